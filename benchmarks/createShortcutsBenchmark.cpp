@@ -0,0 +1,388 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+// Times ShortcutsPortal::createShortcuts() and its memory against collections synthesized
+// by the libobs stub, and compares it with what it replaced:
+// - the source and filter walk the hotkey seed used to validate registerers
+// - the registry layouts before the parallel arrays, a QMap and a vector of structs
+//   holding QStrings and a std::function
+//
+// Each size runs in its own process so the peak RSS belongs to that size alone.
+
+#include "obsStub.h"
+#include "shortcutRegistry.h"
+#include "shortcutsPortal.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QProcess>
+#include <QSet>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace Qt::Literals::StringLiterals;
+
+static const size_t defaultSizes[] = {10, 100, 1000, 10000, 100000};
+static const size_t walkSourceCounts[] = {100, 1000, 10000, 50000};
+static constexpr size_t walkHotkeys = 1000;
+
+// bytes malloc handed out, including the large blocks it mmaps
+static size_t heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    const struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+static long currentRssKiB()
+{
+    long pages = 0;
+    long resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(statm);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static long peakRssKiB()
+{
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static double median(std::vector<double> values)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+// What the hotkey seed did before registerers were resolved through their weak references:
+// every source and every filter went into a set first
+static size_t legacyRegistererWalk()
+{
+    QSet<void*> validSources;
+    obs_enum_sources([](void* data, obs_source_t* source) {
+        auto* set = static_cast<QSet<void*>*>(data);
+        set->insert(static_cast<void*>(source));
+
+        obs_source_enum_filters(source, [](obs_source_t*, obs_source_t* filter, void* p) {
+            auto* s = static_cast<QSet<void*>*>(p);
+            s->insert(static_cast<void*>(filter));
+        }, set);
+
+        return true;
+    }, &validSources);
+
+    return static_cast<size_t>(validSources.size());
+}
+
+// The shortcut before the registry became parallel arrays over one text buffer
+struct LegacyShortcut
+{
+    QString name;
+    QString description;
+    ShortcutCategory category = ShortcutCategory::Hotkey;
+    QString target;
+    std::function<void(bool pressed)> callbackFunc;
+};
+
+struct ShortcutRow
+{
+    QString name;
+    QString description;
+    ShortcutCategory category;
+    QString target;
+};
+
+static void noToggle() {}
+
+// a fresh copy, sharing the data of the row would hide the allocation
+static QString copy(const QString& text)
+{
+    return QString(text.constData(), text.size());
+}
+
+static LegacyShortcut legacyShortcut(const ShortcutRow& row, obs_hotkey_id id)
+{
+    LegacyShortcut shortcut;
+    shortcut.name = copy(row.name);
+    shortcut.description = copy(row.description);
+    shortcut.category = row.category;
+    shortcut.target = copy(row.target);
+
+    if (row.category == ShortcutCategory::Hotkey) {
+        shortcut.callbackFunc = [id](bool pressed) {
+            obs_hotkey_trigger_routed_callback(id, pressed);
+        };
+    } else if (row.category == ShortcutCategory::Scene) {
+        obs_weak_source_t* weakScene = nullptr;
+        shortcut.callbackFunc = [weakScene](bool pressed) {
+            if (pressed && weakScene) {
+                obs_frontend_set_current_scene(obs_weak_source_get_source(weakScene));
+            }
+        };
+    } else {
+        shortcut.callbackFunc = [](bool pressed) {
+            if (pressed) {
+                noToggle();
+            }
+        };
+    }
+    return shortcut;
+}
+
+// heap kept by what build() returns, the result is destroyed afterwards
+template<typename Build> static size_t heapDelta(Build build)
+{
+    const size_t before = heapInUse();
+    auto result = build();
+    return heapInUse() - before;
+}
+
+// Child process: one collection size, prints a single line of numbers
+static int runSize(size_t hotkeys)
+{
+    QTemporaryDir configDir;
+    ObsStub::setConfigDir(configDir.path().toUtf8().constData());
+    ObsStub::populate(ObsStub::forHotkeys(hotkeys));
+
+    const long startRss = currentRssKiB();
+    const size_t startHeap = heapInUse();
+
+    ShortcutsPortal portal;
+
+    QElapsedTimer timer;
+    timer.start();
+    portal.createShortcuts();
+    const double firstMs = timer.nsecsElapsed() / 1e6;
+    const size_t heap = heapInUse() - startHeap;
+
+    // the hotkeys are only seeded by the first build
+    std::vector<double> rebuildMs;
+    const int rebuilds = hotkeys >= 100000 ? 3 : 10;
+    for (int i = 0; i < rebuilds; i++) {
+        timer.start();
+        portal.createShortcuts();
+        rebuildMs.push_back(timer.nsecsElapsed() / 1e6);
+    }
+
+    const std::shared_ptr<const ShortcutRegistry> registry = portal.shortcuts();
+    printf("%zu %lld %.3f %.3f %zu %zu %ld %ld\n",
+           hotkeys,
+           static_cast<long long>(registry->size()),
+           firstMs,
+           median(rebuildMs),
+           registry->memoryUsage(),
+           heap,
+           startRss,
+           peakRssKiB());
+    return 0;
+}
+
+static void reportSizes(const std::vector<size_t>& sizes)
+{
+    printf("createShortcuts() by collection size, each in its own process\n");
+    printf("%9s %10s %15s %11s %13s %10s %14s\n", "hotkeys", "shortcuts", "first build ms", "rebuild ms", "registry KiB", "heap KiB", "peak RSS MiB");
+
+    for (size_t hotkeys : sizes) {
+        QProcess child;
+        child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        child.start(QCoreApplication::applicationFilePath(), {u"--size"_s, QString::number(hotkeys)});
+        if (!child.waitForFinished(-1) || child.exitCode() != 0) {
+            printf("%9zu failed\n", hotkeys);
+            continue;
+        }
+
+        size_t size = 0;
+        long long shortcuts = 0;
+        double firstMs = 0;
+        double rebuildMs = 0;
+        size_t registryBytes = 0;
+        size_t heapBytes = 0;
+        long startRss = 0;
+        long peakRss = 0;
+        const QByteArray line = child.readAllStandardOutput();
+        if (sscanf(line.constData(), "%zu %lld %lf %lf %zu %zu %ld %ld", &size, &shortcuts, &firstMs, &rebuildMs, &registryBytes, &heapBytes, &startRss, &peakRss) != 8) {
+            printf("%9zu unexpected output: %s\n", hotkeys, line.constData());
+            continue;
+        }
+
+        printf("%9zu %10lld %15.2f %11.2f %13zu %10zu %7.1f (+%.1f)\n",
+               size, shortcuts, firstMs, rebuildMs, registryBytes / 1024, heapBytes / 1024, peakRss / 1024.0, (peakRss - startRss) / 1024.0);
+    }
+}
+
+// The first build includes the hotkey seed, which used to walk every source and filter
+static void reportRegistererWalk()
+{
+    printf("\nFirst build (hotkey seed included) by source count, %zu hotkeys, a filter per source\n", walkHotkeys);
+    printf("%9s %9s %12s %16s %13s\n", "sources", "filters", "build ms", "+ old walk ms", "old build ms");
+
+    QTemporaryDir configDir;
+    ObsStub::setConfigDir(configDir.path().toUtf8().constData());
+
+    for (size_t sources : walkSourceCounts) {
+        ObsStub::Sizes sizes;
+        sizes.hotkeys = walkHotkeys;
+        sizes.sources = sources;
+        sizes.filters = sources;
+        sizes.scenes = 10;
+        ObsStub::populate(sizes);
+
+        std::vector<double> buildMs;
+        std::vector<double> walkMs;
+        size_t walked = 0;
+        for (int i = 0; i < 5; i++) {
+            ShortcutsPortal portal;
+
+            QElapsedTimer timer;
+            timer.start();
+            portal.createShortcuts();
+            buildMs.push_back(timer.nsecsElapsed() / 1e6);
+
+            timer.start();
+            walked = legacyRegistererWalk();
+            walkMs.push_back(timer.nsecsElapsed() / 1e6);
+        }
+
+        if (walked != sources * 2) {
+            printf("walk saw %zu of %zu sources and filters\n", walked, sources * 2);
+        }
+
+        const double build = median(buildMs);
+        const double walk = median(walkMs);
+        printf("%9zu %9zu %12.2f %16.2f %13.2f\n", sources, sources, build, walk, build + walk);
+    }
+}
+
+// Heap taken by the same shortcuts in the registry and in the layouts it replaced.
+// The old layouts are measured without their lookup tables, the registry with them.
+static void reportLayouts(const std::vector<size_t>& sizes)
+{
+    printf("\nShortcut storage by layout, heap KiB\n");
+    printf("%9s %10s %14s %16s %14s\n", "hotkeys", "shortcuts", "QMap+function", "vector+function", "registry");
+
+    QTemporaryDir configDir;
+    ObsStub::setConfigDir(configDir.path().toUtf8().constData());
+
+    for (size_t hotkeys : sizes) {
+        if (hotkeys < 1000) {
+            continue;
+        }
+
+        ObsStub::populate(ObsStub::forHotkeys(hotkeys));
+
+        std::vector<ShortcutRow> rows;
+        {
+            ShortcutsPortal portal;
+            portal.createShortcuts();
+
+            const std::shared_ptr<const ShortcutRegistry> registry = portal.shortcuts();
+            for (qsizetype i = 0; i < registry->size(); i++) {
+                rows.push_back(ShortcutRow{
+                    registry->name(i).toString(),
+                    registry->description(i).toString(),
+                    registry->category(i),
+                    registry->target(i).toString(),
+                });
+            }
+        }
+
+        const size_t mapBytes = heapDelta([&rows]() {
+            QMap<QString, LegacyShortcut> shortcuts;
+            for (size_t i = 0; i < rows.size(); i++) {
+                LegacyShortcut shortcut = legacyShortcut(rows[i], i);
+                shortcuts.insert(shortcut.name, shortcut);
+            }
+            return shortcuts;
+        });
+
+        const size_t vectorBytes = heapDelta([&rows]() {
+            std::vector<LegacyShortcut> shortcuts;
+            for (size_t i = 0; i < rows.size(); i++) {
+                shortcuts.push_back(legacyShortcut(rows[i], i));
+            }
+            return shortcuts;
+        });
+
+        const size_t registryBytes = heapDelta([&rows]() {
+            auto registry = std::make_unique<ShortcutRegistry>();
+            for (size_t i = 0; i < rows.size(); i++) {
+                const ShortcutRow& row = rows[i];
+                ShortcutAction action = ShortcutAction::lazyScene();
+                if (row.category == ShortcutCategory::Hotkey) {
+                    action = ShortcutAction::triggerHotkey(i, false);
+                } else if (row.category == ShortcutCategory::Toggle) {
+                    action = ShortcutAction::runToggle(noToggle);
+                }
+                registry->insert(copy(row.name), copy(row.description), row.category, copy(row.target), action);
+            }
+            registry->finalize();
+            return registry;
+        });
+
+        printf("%9zu %10zu %14zu %16zu %14zu\n", hotkeys, rows.size(), mapBytes / 1024, vectorBytes / 1024, registryBytes / 1024);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // nothing here needs a portal, keep the plugin off the desktop's session bus
+    setenv("DBUS_SESSION_BUS_ADDRESS", "unix:path=/nonexistent", 1);
+
+    QCoreApplication app(argc, argv);
+
+    if (argc == 3 && strcmp(argv[1], "--size") == 0) {
+        return runSize(strtoull(argv[2], nullptr, 10));
+    }
+
+    std::vector<size_t> sizes(std::begin(defaultSizes), std::end(defaultSizes));
+    if (argc > 1) {
+        sizes.clear();
+        for (int i = 1; i < argc; i++) {
+            sizes.push_back(strtoull(argv[i], nullptr, 10));
+        }
+    }
+
+    reportSizes(sizes);
+    reportRegistererWalk();
+    reportLayouts(sizes);
+    return 0;
+}
@@ -0,0 +1,221 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "mockPortal.h"
+
+using namespace Qt::Literals::StringLiterals;
+
+static const QString connectionName = u"mock_portal"_s;
+static const QString freedesktopDest = u"org.freedesktop.portal.Desktop"_s;
+static const QString freedesktopPath = u"/org/freedesktop/portal/desktop"_s;
+static const QString globalShortcutsInterface = u"org.freedesktop.portal.GlobalShortcuts"_s;
+
+// ":1.42" becomes "1_42", like in the request and session paths of xdg-desktop-portal
+static QString senderElement(const QString& sender)
+{
+    QString element = sender.mid(1);
+    element.replace(u'.', u'_');
+    return element;
+}
+
+MockPortal::MockPortal(const QString& address, QObject* parent)
+    : QObject(parent),
+      m_bus(QDBusConnection::connectToBus(address, connectionName))
+{
+    qDBusRegisterMetaType<std::pair<QString, QVariantMap>>();
+    qDBusRegisterMetaType<QList<QPair<QString, QVariantMap>>>();
+
+    if (!m_bus.isConnected()) {
+        return;
+    }
+
+    m_registered = m_bus.registerObject(
+                       freedesktopPath,
+                       this,
+                       QDBusConnection::ExportAllSlots | QDBusConnection::ExportAllProperties
+                   ) &&
+                   m_bus.registerService(freedesktopDest);
+}
+
+MockPortal::~MockPortal()
+{
+    m_bus.unregisterService(freedesktopDest);
+    m_bus.unregisterObject(freedesktopPath);
+    QDBusConnection::disconnectFromBus(connectionName);
+}
+
+void MockPortal::respond(const QDBusMessage& message, const QString& requestPath, const QVariantMap& results)
+{
+    message.setDelayedReply(true);
+    m_bus.send(message.createReply(QVariant::fromValue(QDBusObjectPath(requestPath))));
+
+    QDBusMessage response = QDBusMessage::createTargetedSignal(
+        message.service(),
+        requestPath,
+        u"org.freedesktop.portal.Request"_s,
+        u"Response"_s
+    );
+    response << 0u << results;
+    m_bus.send(response);
+}
+
+QDBusObjectPath MockPortal::CreateSession(const QVariantMap& options, const QDBusMessage& message)
+{
+    const QString sender = senderElement(message.service());
+    const QString requestPath = u"/org/freedesktop/portal/desktop/request/"_s + sender + u'/' + options.value(u"handle_token"_s).toString();
+    const QString sessionPath = u"/org/freedesktop/portal/desktop/session/"_s + sender + u'/' + options.value(u"session_handle_token"_s).toString();
+
+    auto* session = new MockSession(this, sessionPath);
+    if (!m_bus.registerObject(sessionPath, session, QDBusConnection::ExportAllSlots)) {
+        delete session;
+
+        message.setDelayedReply(true);
+        m_bus.send(message.createErrorReply(QDBusError::InvalidArgs, u"Session %1 already exists"_s.arg(sessionPath)));
+        return {};
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_sessions.insert(sessionPath, Session{message.service(), session, {}});
+    }
+
+    respond(message, requestPath, {{u"session_handle"_s, sessionPath}});
+    return {};
+}
+
+QDBusObjectPath MockPortal::BindShortcuts(
+    const QDBusObjectPath& sessionHandle,
+    const QList<QPair<QString, QVariantMap>>& shortcuts,
+    const QString& parentWindow,
+    const QVariantMap& options,
+    const QDBusMessage& message
+)
+{
+    m_bindRequests.fetch_add(1, std::memory_order_relaxed);
+
+    QString token = options.value(u"handle_token"_s).toString();
+    if (token.isEmpty()) {
+        token = u"mock_"_s + QString::number(++m_requestSerial);
+    }
+    const QString requestPath = u"/org/freedesktop/portal/desktop/request/"_s + senderElement(message.service()) + u'/' + token;
+
+    // the portal answers with what it bound, including the trigger it picked for each
+    QList<QPair<QString, QVariantMap>> bound;
+    bound.reserve(shortcuts.size());
+
+    {
+        std::lock_guard lock(m_mutex);
+
+        auto session = m_sessions.find(sessionHandle.path());
+        if (session == m_sessions.end() || session->owner != message.service()) {
+            message.setDelayedReply(true);
+            m_bus.send(message.createErrorReply(QDBusError::InvalidArgs, u"Unknown session %1"_s.arg(sessionHandle.path())));
+            return {};
+        }
+
+        // BindShortcuts replaces everything the session had
+        for (const auto& [id, description] : session->shortcuts) {
+            if (m_shortcutSessions.value(id) == sessionHandle.path()) {
+                m_shortcutSessions.remove(id);
+            }
+        }
+        session->shortcuts.clear();
+        session->shortcuts.reserve(shortcuts.size());
+
+        for (const auto& [id, properties] : shortcuts) {
+            const QString description = properties.value(u"description"_s).toString();
+            session->shortcuts.emplaceBack(id, description);
+            m_shortcutSessions.insert(id, sessionHandle.path());
+
+            bound.emplaceBack(id, QVariantMap{{u"description"_s, description}, {u"trigger_description"_s, QString()}});
+        }
+    }
+
+    respond(message, requestPath, {{u"shortcuts"_s, QVariant::fromValue(bound)}});
+    return {};
+}
+
+void MockPortal::ConfigureShortcuts(const QDBusObjectPath& sessionHandle, const QString& parentWindow, const QVariantMap& options)
+{
+    // a real portal would open its settings here
+}
+
+void MockPortal::closeSession(const QString& path)
+{
+    MockSession* object = nullptr;
+
+    {
+        std::lock_guard lock(m_mutex);
+
+        auto session = m_sessions.find(path);
+        if (session == m_sessions.end()) {
+            return;
+        }
+
+        for (const auto& [id, description] : session->shortcuts) {
+            if (m_shortcutSessions.value(id) == path) {
+                m_shortcutSessions.remove(id);
+            }
+        }
+
+        object = session->object;
+        m_sessions.erase(session);
+    }
+
+    m_bus.unregisterObject(path);
+    // still running its Close()
+    object->deleteLater();
+}
+
+bool MockPortal::sendShortcut(const QString& id, bool pressed, uint64_t timestampMs)
+{
+    QString sessionPath;
+    QString owner;
+
+    {
+        std::lock_guard lock(m_mutex);
+
+        auto session = m_shortcutSessions.constFind(id);
+        if (session == m_shortcutSessions.cend()) {
+            return false;
+        }
+        sessionPath = session.value();
+        owner = m_sessions.value(sessionPath).owner;
+    }
+
+    QDBusMessage signal = QDBusMessage::createTargetedSignal(
+        owner,
+        freedesktopPath,
+        globalShortcutsInterface,
+        pressed ? u"Activated"_s : u"Deactivated"_s
+    );
+    signal << QVariant::fromValue(QDBusObjectPath(sessionPath)) << id << QVariant::fromValue(qulonglong(timestampMs)) << QVariantMap();
+
+    return m_bus.send(signal);
+}
+
+QList<QPair<QString, QString>> MockPortal::boundShortcuts() const
+{
+    std::lock_guard lock(m_mutex);
+
+    QList<QPair<QString, QString>> shortcuts;
+    for (const Session& session : m_sessions) {
+        shortcuts.append(session.shortcuts);
+    }
+    return shortcuts;
+}
@@ -0,0 +1,128 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QtDBus/QtDBus>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+class MockSession;
+
+// Test-only org.freedesktop.portal.GlobalShortcuts, owning org.freedesktop.portal.Desktop
+// through a connection of its own. Every request is answered right away: the reply
+// carries the request path, the Response follows from that path. Nothing is shown to
+// a user, BindShortcuts accepts whatever it is sent.
+class MockPortal : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.portal.GlobalShortcuts")
+    Q_PROPERTY(uint version READ version CONSTANT)
+public:
+    // address of the bus to register on, e.g. the private one of a benchmark
+    explicit MockPortal(const QString& address, QObject* parent = nullptr);
+    ~MockPortal();
+
+    // the name and the object are registered, the portal can be used
+    bool isRegistered() const
+    {
+        return m_registered;
+    }
+
+    uint version() const
+    {
+        return 2;
+    }
+
+    // Emits Activated, or Deactivated when released, to the connection whose session bound
+    // the shortcut. False if no open session has it. Can be called from any thread.
+    bool sendShortcut(const QString& id, bool pressed, uint64_t timestampMs);
+
+    // id and description of every shortcut bound by an open session
+    QList<QPair<QString, QString>> boundShortcuts() const;
+
+    int bindRequests() const
+    {
+        return m_bindRequests.load(std::memory_order_relaxed);
+    }
+
+    // Session.Close, unregisters the session and forgets what it bound
+    void closeSession(const QString& path);
+
+public Q_SLOTS:
+    QDBusObjectPath CreateSession(const QVariantMap& options, const QDBusMessage& message);
+    QDBusObjectPath BindShortcuts(
+        const QDBusObjectPath& sessionHandle,
+        const QList<QPair<QString, QVariantMap>>& shortcuts,
+        const QString& parentWindow,
+        const QVariantMap& options,
+        const QDBusMessage& message
+    );
+    void ConfigureShortcuts(const QDBusObjectPath& sessionHandle, const QString& parentWindow, const QVariantMap& options);
+
+private:
+    // sends the reply with the request path, then the Response of that request
+    void respond(const QDBusMessage& message, const QString& requestPath, const QVariantMap& results);
+
+    struct Session
+    {
+        // unique name of the connection that created it
+        QString owner;
+        MockSession* object = nullptr;
+        QList<QPair<QString, QString>> shortcuts;
+    };
+
+    QDBusConnection m_bus;
+    bool m_registered = false;
+
+    // guards the sessions, sendShortcut() reads them from other threads
+    mutable std::mutex m_mutex;
+    QHash<QString, Session> m_sessions;
+    // session path by shortcut id
+    QHash<QString, QString> m_shortcutSessions;
+
+    std::atomic<int> m_bindRequests{0};
+    uint m_requestSerial = 0;
+};
+
+// org.freedesktop.portal.Session of one MockPortal session
+class MockSession : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.portal.Session")
+public:
+    MockSession(MockPortal* portal, const QString& path)
+        : QObject(portal),
+          m_portal(portal),
+          m_path(path)
+    {
+    }
+
+public Q_SLOTS:
+    void Close()
+    {
+        m_portal->closeSession(m_path);
+    }
+
+private:
+    MockPortal* m_portal;
+    QString m_path;
+};
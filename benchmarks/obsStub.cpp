@@ -0,0 +1,756 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "obsStub.h"
+
+#include <obs-hotkey.h>
+#include <obs-module.h>
+#include <util/bmem.h>
+#include <util/config-file.h>
+#include <util/platform.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct obs_weak_source
+{
+    obs_source_t* source;
+};
+
+struct obs_source
+{
+    std::string name;
+    std::string uuid;
+    obs_source_type type = OBS_SOURCE_TYPE_INPUT;
+    // replaced by a later populate(), weak references can't be upgraded anymore
+    bool removed = false;
+    obs_weak_source weak{this};
+    std::vector<obs_source_t*> filters;
+};
+
+struct obs_hotkey
+{
+    obs_hotkey_id id;
+    std::string name;
+    std::string description;
+    obs_hotkey_registerer_t registererType;
+    // the weak reference of a source, null for the frontend, like in libobs
+    void* registerer;
+};
+
+struct signal_handler
+{
+};
+
+struct config_data
+{
+    // by "section\nname", a default only counts while nothing was set
+    std::map<std::string, int64_t> values;
+    std::map<std::string, int64_t> defaults;
+};
+
+struct FrontendCallback
+{
+    obs_frontend_event_cb callback;
+    void* data;
+};
+
+struct TickCallback
+{
+    void (*tick)(void* param, float seconds);
+    void* param;
+};
+
+static const char* const frontendHotkeys[][2] = {
+    {"OBSBasic.StartStreaming", "Start Streaming"},
+    {"OBSBasic.StopStreaming", "Stop Streaming"},
+    {"OBSBasic.StartRecording", "Start Recording"},
+    {"OBSBasic.StopRecording", "Stop Recording"},
+    {"OBSBasic.PauseRecording", "Pause Recording"},
+    {"OBSBasic.UnpauseRecording", "Unpause Recording"},
+    {"OBSBasic.StartReplayBuffer", "Start Replay Buffer"},
+    {"OBSBasic.StopReplayBuffer", "Stop Replay Buffer"},
+    {"OBSBasic.StartVirtualCam", "Start Virtual Camera"},
+    {"OBSBasic.StopVirtualCam", "Stop Virtual Camera"},
+    {"OBSBasic.EnablePreview", "Enable Preview"},
+    {"OBSBasic.DisablePreview", "Disable Preview"},
+};
+
+// what an audio source registers, further hotkeys of the same source are numbered
+static const char* const sourceHotkeys[][2] = {
+    {"libobs.mute", "Mute"},
+    {"libobs.unmute", "Unmute"},
+    {"libobs.push-to-mute", "Push-to-mute"},
+    {"libobs.push-to-talk", "Push-to-talk"},
+};
+
+static struct
+{
+    // every source ever populated, so weak references to removed ones stay readable
+    std::vector<std::unique_ptr<obs_source_t>> allSources;
+    std::vector<obs_source_t*> scenes;
+    std::vector<obs_source_t*> inputs;
+    std::unordered_map<std::string, obs_source_t*> sourcesByName;
+    std::unordered_map<std::string, obs_source_t*> sourcesByUuid;
+    std::vector<obs_hotkey_t> hotkeys;
+
+    std::atomic<void (*)(obs_hotkey_id id, bool pressed)> hotkeyCallback{nullptr};
+    std::vector<FrontendCallback> frontendCallbacks;
+    std::atomic<size_t> frontendCalls{0};
+
+    std::atomic<bool> streaming{false};
+    std::atomic<bool> recording{false};
+    std::atomic<bool> replayBuffer{false};
+    std::atomic<bool> virtualcam{false};
+    std::atomic<bool> studioMode{false};
+    std::atomic<bool> preview{true};
+
+    std::mutex tickMutex;
+    std::vector<TickCallback> ticks;
+    std::thread videoThread;
+    std::atomic<bool> videoRunning{false};
+
+    signal_handler_t signals;
+    config_t config;
+    std::string configDir;
+
+    std::mutex logMutex;
+    std::atomic<int> logLevel{LOG_WARNING};
+} stub;
+
+static std::string makeUuid(size_t number)
+{
+    char uuid[37];
+    snprintf(uuid, sizeof(uuid), "00000000-0000-4000-8000-%012zx", number);
+    return uuid;
+}
+
+static obs_source_t* addSource(std::string name, obs_source_type type)
+{
+    auto source = std::make_unique<obs_source_t>();
+    source->name = std::move(name);
+    source->uuid = makeUuid(stub.sourcesByUuid.size());
+    source->type = type;
+
+    obs_source_t* added = source.get();
+    stub.allSources.push_back(std::move(source));
+
+    // filters can't be looked up by name in libobs either
+    if (type != OBS_SOURCE_TYPE_FILTER) {
+        stub.sourcesByName[added->name] = added;
+    }
+    stub.sourcesByUuid[added->uuid] = added;
+    return added;
+}
+
+static void addHotkey(std::string name, std::string description, obs_hotkey_registerer_t type, void* registerer)
+{
+    const obs_hotkey_id id = stub.hotkeys.size();
+    stub.hotkeys.push_back(obs_hotkey_t{id, std::move(name), std::move(description), type, registerer});
+}
+
+ObsStub::Sizes ObsStub::forHotkeys(size_t hotkeys)
+{
+    Sizes sizes;
+    sizes.hotkeys = hotkeys;
+    sizes.sources = std::max<size_t>(hotkeys / 4, 1);
+    sizes.filters = sizes.sources / 2;
+    sizes.scenes = std::clamp<size_t>(hotkeys / 50, 1, 500);
+    return sizes;
+}
+
+void ObsStub::populate(const Sizes& sizes)
+{
+    for (auto& source : stub.allSources) {
+        source->removed = true;
+    }
+    stub.scenes.clear();
+    stub.inputs.clear();
+    stub.sourcesByName.clear();
+    stub.sourcesByUuid.clear();
+    stub.hotkeys.clear();
+
+    // uuids and hotkey ids restart, so populating the same sizes again gives the same collection
+    for (size_t i = 0; i < sizes.scenes; i++) {
+        stub.scenes.push_back(addSource("Scene " + std::to_string(i + 1), OBS_SOURCE_TYPE_SCENE));
+    }
+
+    for (size_t i = 0; i < sizes.sources; i++) {
+        stub.inputs.push_back(addSource("Source " + std::to_string(i + 1), OBS_SOURCE_TYPE_INPUT));
+    }
+
+    std::vector<obs_source_t*> registerers = stub.inputs;
+    for (size_t i = 0; i < sizes.filters && !stub.inputs.empty(); i++) {
+        obs_source_t* filter = addSource("Filter " + std::to_string(i + 1), OBS_SOURCE_TYPE_FILTER);
+        stub.inputs[i % stub.inputs.size()]->filters.push_back(filter);
+        registerers.push_back(filter);
+    }
+
+    const size_t frontendCount = std::min(sizes.hotkeys, std::size(frontendHotkeys));
+    for (size_t i = 0; i < frontendCount; i++) {
+        addHotkey(frontendHotkeys[i][0], frontendHotkeys[i][1], OBS_HOTKEY_REGISTERER_FRONTEND, nullptr);
+    }
+
+    // handed out in turns, so every registerer gets its mute and push-to-talk hotkeys first
+    for (size_t i = 0; i < sizes.hotkeys - frontendCount; i++) {
+        if (registerers.empty()) {
+            addHotkey("OBSBasic.Hotkey" + std::to_string(i), "Hotkey " + std::to_string(i), OBS_HOTKEY_REGISTERER_FRONTEND, nullptr);
+            continue;
+        }
+
+        obs_source_t* source = registerers[i % registerers.size()];
+        const size_t slot = i / registerers.size();
+        if (slot < std::size(sourceHotkeys)) {
+            addHotkey(sourceHotkeys[slot][0], sourceHotkeys[slot][1], OBS_HOTKEY_REGISTERER_SOURCE, &source->weak);
+        } else {
+            addHotkey("libobs.hotkey" + std::to_string(slot), "Hotkey " + std::to_string(slot), OBS_HOTKEY_REGISTERER_SOURCE, &source->weak);
+        }
+    }
+}
+
+void ObsStub::setHotkeyCallback(void (*callback)(obs_hotkey_id id, bool pressed))
+{
+    stub.hotkeyCallback = callback;
+}
+
+void ObsStub::sendFrontendEvent(obs_frontend_event event)
+{
+    // a callback may remove itself
+    const std::vector<FrontendCallback> callbacks = stub.frontendCallbacks;
+    for (const FrontendCallback& entry : callbacks) {
+        entry.callback(event, entry.data);
+    }
+}
+
+void ObsStub::startVideo(int fps)
+{
+    stopVideo();
+
+    stub.videoRunning = true;
+    stub.videoThread = std::thread([fps]() {
+        const auto interval = std::chrono::nanoseconds(1000000000 / std::max(fps, 1));
+        const float seconds = 1.0f / std::max(fps, 1);
+        auto next = std::chrono::steady_clock::now();
+
+        while (stub.videoRunning) {
+            next += interval;
+            std::this_thread::sleep_until(next);
+
+            // held while ticking, so a removed callback is never called afterwards
+            std::lock_guard lock(stub.tickMutex);
+            for (const TickCallback& callback : stub.ticks) {
+                callback.tick(callback.param, seconds);
+            }
+        }
+    });
+}
+
+void ObsStub::stopVideo()
+{
+    stub.videoRunning = false;
+    if (stub.videoThread.joinable()) {
+        stub.videoThread.join();
+    }
+}
+
+void ObsStub::setConfigDir(const char* path)
+{
+    stub.configDir = path;
+    if (mkdir(path, 0700) != 0 && errno != EEXIST) {
+        blog(LOG_ERROR, "[ObsStub] Failed to create %s: %s", path, strerror(errno));
+    }
+}
+
+void ObsStub::setLogLevel(int level)
+{
+    stub.logLevel = level;
+}
+
+size_t ObsStub::frontendCalls()
+{
+    return stub.frontendCalls;
+}
+
+static void frontendCall()
+{
+    stub.frontendCalls++;
+}
+
+// util
+
+void blog(int log_level, const char* format, ...)
+{
+    if (log_level > stub.logLevel) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    {
+        std::lock_guard lock(stub.logMutex);
+        vfprintf(stderr, format, args);
+        fputc('\n', stderr);
+    }
+    va_end(args);
+}
+
+void* bmalloc(size_t size)
+{
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void* brealloc(void* ptr, size_t size)
+{
+    ptr = realloc(ptr, size ? size : 1);
+    if (!ptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void bfree(void* ptr)
+{
+    free(ptr);
+}
+
+void* bmemdup(const void* ptr, size_t size)
+{
+    void* out = bmalloc(size);
+    if (size) {
+        memcpy(out, ptr, size);
+    }
+    return out;
+}
+
+uint64_t os_gettime_ns(void)
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+static std::string configKey(const char* section, const char* name)
+{
+    return std::string(section) + '\n' + name;
+}
+
+static int64_t configValue(config_t* config, const char* section, const char* name)
+{
+    const std::string key = configKey(section, name);
+    auto it = config->values.find(key);
+    if (it != config->values.end()) {
+        return it->second;
+    }
+
+    it = config->defaults.find(key);
+    return it != config->defaults.end() ? it->second : 0;
+}
+
+void config_set_bool(config_t* config, const char* section, const char* name, bool value)
+{
+    config->values[configKey(section, name)] = value;
+}
+
+void config_set_int(config_t* config, const char* section, const char* name, int64_t value)
+{
+    config->values[configKey(section, name)] = value;
+}
+
+void config_set_default_bool(config_t* config, const char* section, const char* name, bool value)
+{
+    config->defaults[configKey(section, name)] = value;
+}
+
+void config_set_default_int(config_t* config, const char* section, const char* name, int64_t value)
+{
+    config->defaults[configKey(section, name)] = value;
+}
+
+bool config_get_bool(config_t* config, const char* section, const char* name)
+{
+    return configValue(config, section, name) != 0;
+}
+
+int64_t config_get_int(config_t* config, const char* section, const char* name)
+{
+    return configValue(config, section, name);
+}
+
+// callbacks and signals, nothing is ever emitted
+
+signal_handler_t* obs_get_signal_handler(void)
+{
+    return &stub.signals;
+}
+
+void signal_handler_connect(signal_handler_t*, const char*, signal_callback_t, void*) {}
+
+void signal_handler_disconnect(signal_handler_t*, const char*, signal_callback_t, void*) {}
+
+bool calldata_get_data(const calldata_t*, const char*, void*, size_t)
+{
+    return false;
+}
+
+bool calldata_get_string(const calldata_t*, const char*, const char**)
+{
+    return false;
+}
+
+void obs_add_tick_callback(void (*tick)(void* param, float seconds), void* param)
+{
+    std::lock_guard lock(stub.tickMutex);
+    stub.ticks.push_back(TickCallback{tick, param});
+}
+
+void obs_remove_tick_callback(void (*tick)(void* param, float seconds), void* param)
+{
+    std::lock_guard lock(stub.tickMutex);
+    stub.ticks.erase(std::remove_if(stub.ticks.begin(), stub.ticks.end(), [tick, param](const TickCallback& callback) {
+        return callback.tick == tick && callback.param == param;
+    }), stub.ticks.end());
+}
+
+// module
+
+obs_module_t* obs_current_module(void)
+{
+    return nullptr;
+}
+
+char* obs_module_get_config_path(obs_module_t*, const char* file)
+{
+    if (stub.configDir.empty()) {
+        const char* tmp = getenv("TMPDIR");
+        std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") + "/obs-stub-XXXXXX";
+        if (mkdtemp(pattern.data())) {
+            stub.configDir = pattern;
+        }
+    }
+
+    const std::string path = stub.configDir + '/' + file;
+    return bstrdup(path.c_str());
+}
+
+// hotkeys
+
+void obs_enum_hotkeys(obs_hotkey_enum_func func, void* data)
+{
+    for (obs_hotkey_t& hotkey : stub.hotkeys) {
+        if (!func(data, hotkey.id, &hotkey)) {
+            break;
+        }
+    }
+}
+
+obs_hotkey_id obs_hotkey_get_id(const obs_hotkey_t* key)
+{
+    return key->id;
+}
+
+const char* obs_hotkey_get_name(const obs_hotkey_t* key)
+{
+    return key->name.c_str();
+}
+
+const char* obs_hotkey_get_description(const obs_hotkey_t* key)
+{
+    return key->description.c_str();
+}
+
+obs_hotkey_registerer_t obs_hotkey_get_registerer_type(const obs_hotkey_t* key)
+{
+    return key->registererType;
+}
+
+void* obs_hotkey_get_registerer(const obs_hotkey_t* key)
+{
+    return key->registerer;
+}
+
+void obs_hotkey_trigger_routed_callback(obs_hotkey_id id, bool pressed)
+{
+    if (auto callback = stub.hotkeyCallback.load()) {
+        callback(id, pressed);
+    }
+}
+
+// sources
+
+void obs_enum_sources(bool (*enum_proc)(void*, obs_source_t*), void* param)
+{
+    for (obs_source_t* source : stub.inputs) {
+        if (!enum_proc(param, source)) {
+            break;
+        }
+    }
+}
+
+void obs_source_enum_filters(obs_source_t* source, obs_source_enum_proc_t callback, void* param)
+{
+    for (obs_source_t* filter : source->filters) {
+        callback(source, filter, param);
+    }
+}
+
+obs_source_t* obs_get_source_by_name(const char* name)
+{
+    auto it = stub.sourcesByName.find(name);
+    return it != stub.sourcesByName.end() ? it->second : nullptr;
+}
+
+obs_source_t* obs_get_source_by_uuid(const char* uuid)
+{
+    auto it = stub.sourcesByUuid.find(uuid);
+    return it != stub.sourcesByUuid.end() ? it->second : nullptr;
+}
+
+obs_source_t* obs_source_get_ref(obs_source_t* source)
+{
+    return source;
+}
+
+void obs_source_release(obs_source_t*) {}
+
+obs_weak_source_t* obs_source_get_weak_source(obs_source_t* source)
+{
+    return source ? &source->weak : nullptr;
+}
+
+obs_source_t* obs_weak_source_get_source(obs_weak_source_t* weak)
+{
+    return weak && !weak->source->removed ? weak->source : nullptr;
+}
+
+void obs_weak_source_release(obs_weak_source_t*) {}
+
+const char* obs_source_get_name(const obs_source_t* source)
+{
+    return source ? source->name.c_str() : nullptr;
+}
+
+const char* obs_source_get_uuid(const obs_source_t* source)
+{
+    return source ? source->uuid.c_str() : nullptr;
+}
+
+enum obs_source_type obs_source_get_type(const obs_source_t* source)
+{
+    return source ? source->type : OBS_SOURCE_TYPE_INPUT;
+}
+
+bool obs_source_is_scene(const obs_source_t* source)
+{
+    return source && source->type == OBS_SOURCE_TYPE_SCENE;
+}
+
+// outputs, encoders and services are never synthesized
+
+obs_output_t* obs_weak_output_get_output(obs_weak_output_t*)
+{
+    return nullptr;
+}
+
+const char* obs_output_get_name(const obs_output_t*)
+{
+    return nullptr;
+}
+
+void obs_output_release(obs_output_t*) {}
+
+obs_encoder_t* obs_weak_encoder_get_encoder(obs_weak_encoder_t*)
+{
+    return nullptr;
+}
+
+const char* obs_encoder_get_name(const obs_encoder_t*)
+{
+    return nullptr;
+}
+
+void obs_encoder_release(obs_encoder_t*) {}
+
+obs_service_t* obs_weak_service_get_service(obs_weak_service_t*)
+{
+    return nullptr;
+}
+
+const char* obs_service_get_name(const obs_service_t*)
+{
+    return nullptr;
+}
+
+void obs_service_release(obs_service_t*) {}
+
+// frontend
+
+void* obs_frontend_get_main_window(void)
+{
+    return nullptr;
+}
+
+config_t* obs_frontend_get_user_config(void)
+{
+    return &stub.config;
+}
+
+char* obs_frontend_get_current_scene_collection(void)
+{
+    return bstrdup("Benchmark");
+}
+
+void obs_frontend_get_scenes(struct obs_frontend_source_list* sources)
+{
+    for (obs_source_t* scene : stub.scenes) {
+        da_push_back(sources->sources, &scene);
+    }
+}
+
+void obs_frontend_set_current_scene(obs_source_t*)
+{
+    frontendCall();
+}
+
+void obs_frontend_add_event_callback(obs_frontend_event_cb callback, void* private_data)
+{
+    stub.frontendCallbacks.push_back(FrontendCallback{callback, private_data});
+}
+
+void obs_frontend_remove_event_callback(obs_frontend_event_cb callback, void* private_data)
+{
+    auto& callbacks = stub.frontendCallbacks;
+    callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), [callback, private_data](const FrontendCallback& entry) {
+        return entry.callback == callback && entry.data == private_data;
+    }), callbacks.end());
+}
+
+static void setState(std::atomic<bool>& state, bool value)
+{
+    state = value;
+    frontendCall();
+}
+
+void obs_frontend_streaming_start(void)
+{
+    setState(stub.streaming, true);
+}
+
+void obs_frontend_streaming_stop(void)
+{
+    setState(stub.streaming, false);
+}
+
+bool obs_frontend_streaming_active(void)
+{
+    return stub.streaming;
+}
+
+void obs_frontend_recording_start(void)
+{
+    setState(stub.recording, true);
+}
+
+void obs_frontend_recording_stop(void)
+{
+    setState(stub.recording, false);
+}
+
+bool obs_frontend_recording_active(void)
+{
+    return stub.recording;
+}
+
+void obs_frontend_recording_pause(bool)
+{
+    frontendCall();
+}
+
+void obs_frontend_replay_buffer_start(void)
+{
+    setState(stub.replayBuffer, true);
+}
+
+void obs_frontend_replay_buffer_stop(void)
+{
+    setState(stub.replayBuffer, false);
+}
+
+void obs_frontend_replay_buffer_save(void)
+{
+    frontendCall();
+}
+
+bool obs_frontend_replay_buffer_active(void)
+{
+    return stub.replayBuffer;
+}
+
+void obs_frontend_start_virtualcam(void)
+{
+    setState(stub.virtualcam, true);
+}
+
+void obs_frontend_stop_virtualcam(void)
+{
+    setState(stub.virtualcam, false);
+}
+
+bool obs_frontend_virtualcam_active(void)
+{
+    return stub.virtualcam;
+}
+
+void obs_frontend_set_preview_program_mode(bool enable)
+{
+    setState(stub.studioMode, enable);
+}
+
+bool obs_frontend_preview_program_mode_active(void)
+{
+    return stub.studioMode;
+}
+
+void obs_frontend_set_preview_enabled(bool enable)
+{
+    setState(stub.preview, enable);
+}
+
+bool obs_frontend_preview_enabled(void)
+{
+    return stub.preview;
+}
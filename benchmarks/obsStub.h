@@ -0,0 +1,69 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <obs-frontend-api.h>
+#include <obs.h>
+
+#include <cstddef>
+
+// Test-only stand-in for the part of libobs and the frontend API the plugin uses, so its
+// code runs without OBS. It is linked instead of libobs and obs-frontend-api and only
+// implements what the plugin calls: reference counts aren't tracked, libobs signals are
+// never emitted and the frontend calls only count how often they were made.
+class ObsStub
+{
+public:
+    struct Sizes
+    {
+        size_t scenes = 0;
+        size_t sources = 0;
+        // spread over the sources
+        size_t filters = 0;
+        // a dozen frontend hotkeys, the rest registered by the sources and filters in turn
+        size_t hotkeys = 0;
+    };
+
+    // A collection of about this many hotkeys: audio sources with mute and push-to-talk,
+    // a filter on every other source and a scene per 50 hotkeys
+    static Sizes forHotkeys(size_t hotkeys);
+
+    // Replaces every scene, source, filter and hotkey. The old objects stay allocated,
+    // weak references to them just can't be upgraded anymore, like after a removal.
+    static void populate(const Sizes& sizes);
+
+    // Called by obs_hotkey_trigger_routed_callback() on the calling thread, null to ignore them
+    static void setHotkeyCallback(void (*callback)(obs_hotkey_id id, bool pressed));
+
+    // Runs the frontend event callbacks right away, OBS does so on the UI thread
+    static void sendFrontendEvent(obs_frontend_event event);
+
+    // Starts a thread that calls the tick callbacks at this rate, like the video thread
+    static void startVideo(int fps);
+    static void stopVideo();
+
+    // Directory obs_module_config_path() points into, a temporary one by default
+    static void setConfigDir(const char* path);
+
+    // blog() drops messages above this level, LOG_WARNING by default
+    static void setLogLevel(int level);
+
+    // obs_frontend_* calls that would have changed something, e.g. a scene switch
+    static size_t frontendCalls();
+};
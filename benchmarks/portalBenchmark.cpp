@@ -0,0 +1,617 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+// Runs PortalSession, ShortcutDispatcher and ShortcutsPortal against MockPortal on a
+// private dbus-daemon and reports:
+// - press to hotkey callback latency, for each way of dispatching, with an idle and a busy UI thread
+// - BindShortcuts round trip by number of shortcuts
+// - rebuilds per second, with and without binding the result
+//
+// Usage: portal-benchmark [presses per run]
+
+#include "mockPortal.h"
+#include "obsStub.h"
+#include "portalSession.h"
+#include "shortcutRegistry.h"
+#include "shortcutsPortal.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <poll.h>
+#include <spawn.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+extern char** environ;
+
+using namespace Qt::Literals::StringLiterals;
+
+static const qsizetype bindCounts[] = {10, 100, 1000, 10000, 50000};
+static const size_t rebuildHotkeys[] = {1000, 10000};
+static constexpr size_t latencyHotkeys = 200;
+static constexpr size_t defaultPresses = 500;
+
+// A dbus-daemon of our own, so neither the mock nor the plugin touch the session bus
+class PrivateBus
+{
+public:
+    ~PrivateBus()
+    {
+        if (m_pid > 0) {
+            kill(m_pid, SIGTERM);
+            waitpid(m_pid, nullptr, 0);
+        }
+        if (!m_dir.empty()) {
+            unlink((m_dir + "/bus.conf").c_str());
+            rmdir(m_dir.c_str());
+        }
+    }
+
+    bool start()
+    {
+        const char* tmp = getenv("TMPDIR");
+        std::string dir = std::string(tmp && *tmp ? tmp : "/tmp") + "/portal-benchmark-XXXXXX";
+        if (!mkdtemp(dir.data())) {
+            return false;
+        }
+        m_dir = dir;
+
+        const std::string configPath = m_dir + "/bus.conf";
+        FILE* config = fopen(configPath.c_str(), "w");
+        if (!config) {
+            return false;
+        }
+        fprintf(config,
+                "<!DOCTYPE busconfig PUBLIC \"-//freedesktop//DTD D-Bus Bus Configuration 1.0//EN\"\n"
+                " \"http://www.freedesktop.org/standards/dbus/1.0/busconfig.dtd\">\n"
+                "<busconfig>\n"
+                "  <type>session</type>\n"
+                "  <listen>unix:tmpdir=%s</listen>\n"
+                "  <auth>EXTERNAL</auth>\n"
+                "  <policy context=\"default\">\n"
+                "    <allow send_destination=\"*\" eavesdrop=\"true\"/>\n"
+                "    <allow eavesdrop=\"true\"/>\n"
+                "    <allow own=\"*\"/>\n"
+                "  </policy>\n"
+                "</busconfig>\n",
+                m_dir.c_str());
+        fclose(config);
+
+        int output[2];
+        if (pipe(output) != 0) {
+            return false;
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, output[1], STDOUT_FILENO);
+        posix_spawn_file_actions_addclose(&actions, output[0]);
+
+        const std::string configArgument = "--config-file=" + configPath;
+        char* argv[] = {
+            const_cast<char*>("dbus-daemon"),
+            const_cast<char*>(configArgument.c_str()),
+            const_cast<char*>("--nofork"),
+            const_cast<char*>("--print-address"),
+            nullptr,
+        };
+
+        const int spawned = posix_spawnp(&m_pid, "dbus-daemon", &actions, nullptr, argv, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(output[1]);
+
+        if (spawned != 0) {
+            m_pid = -1;
+            close(output[0]);
+            return false;
+        }
+
+        // the address is printed once the daemon listens
+        std::string address;
+        char c = 0;
+        pollfd readable{output[0], POLLIN, 0};
+        while (poll(&readable, 1, 5000) > 0 && read(output[0], &c, 1) == 1 && c != '\n') {
+            address += c;
+        }
+        close(output[0]);
+
+        m_address = address;
+        return !m_address.empty();
+    }
+
+    const std::string& address() const
+    {
+        return m_address;
+    }
+
+private:
+    pid_t m_pid = -1;
+    std::string m_dir;
+    std::string m_address;
+};
+
+// Runs the event loop until done() returns true, false if it didn't within the timeout
+static bool waitFor(const std::function<bool()>& done, int timeoutMs = 30000)
+{
+    if (done()) {
+        return true;
+    }
+
+    QEventLoop loop;
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if (done() || elapsed.elapsed() > timeoutMs) {
+            loop.quit();
+        }
+    });
+    poll.start(1);
+    loop.exec();
+
+    return done();
+}
+
+static double median(std::vector<double> values)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+// of sorted values
+static double percentile(const std::vector<double>& values, double fraction)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    const size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    return values[index];
+}
+
+static uint64_t monotonicMs(uint64_t ns)
+{
+    return ns / 1000000;
+}
+
+// ShortcutsPortal against the mock, its shortcuts bound
+class BoundPortal
+{
+public:
+    BoundPortal()
+        : m_portal(std::make_unique<ShortcutsPortal>())
+    {
+        QObject::connect(m_portal.get(), &ShortcutsPortal::shortcutsBound, [this]() {
+            m_binds++;
+        });
+
+        m_portal->createSession();
+        ObsStub::sendFrontendEvent(OBS_FRONTEND_EVENT_FINISHED_LOADING);
+        m_ready = waitForBind(0);
+    }
+
+    ShortcutsPortal* get() const
+    {
+        return m_portal.get();
+    }
+
+    ShortcutsPortal* operator->() const
+    {
+        return m_portal.get();
+    }
+
+    bool isReady() const
+    {
+        return m_ready;
+    }
+
+    // waits for shortcutsBound() to have been emitted more than this many times
+    bool waitForBind(int binds)
+    {
+        return waitFor([this, binds]() {
+            return m_binds > binds;
+        });
+    }
+
+    int binds() const
+    {
+        return m_binds;
+    }
+
+private:
+    std::unique_ptr<ShortcutsPortal> m_portal;
+    int m_binds = 0;
+    bool m_ready = false;
+};
+
+// Hotkey callbacks of one latency run. Only one press is in flight at a time,
+// so the n-th press callback belongs to the n-th press.
+struct PressRun
+{
+    std::vector<uint64_t> sentNs;
+    std::vector<uint64_t> receivedNs;
+    std::atomic<size_t> received{0};
+};
+
+static std::atomic<PressRun*> activeRun{nullptr};
+
+static void onHotkey(obs_hotkey_id, bool pressed)
+{
+    PressRun* run = activeRun.load(std::memory_order_acquire);
+    if (!run || !pressed) {
+        return;
+    }
+
+    const size_t index = run->received.load(std::memory_order_relaxed);
+    if (index < run->receivedNs.size()) {
+        run->receivedNs[index] = os_gettime_ns();
+    }
+    run->received.store(index + 1, std::memory_order_release);
+}
+
+struct LatencyResult
+{
+    std::vector<double> microseconds;
+    size_t lost = 0;
+};
+
+// Presses and releases the shortcuts in turn from a thread standing in for the compositor
+static LatencyResult measureLatency(MockPortal& mock, const QStringList& ids, size_t presses)
+{
+    PressRun run;
+    run.sentNs.resize(presses);
+    run.receivedNs.resize(presses);
+    activeRun.store(&run, std::memory_order_release);
+
+    const auto waitReceived = [&run](size_t count) {
+        const uint64_t deadline = os_gettime_ns() + 1000000000;
+        while (run.received.load(std::memory_order_acquire) < count && os_gettime_ns() < deadline) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        return run.received.load(std::memory_order_acquire) >= count;
+    };
+
+    QEventLoop loop;
+    size_t sent = 0;
+
+    std::thread compositor([&]() {
+        for (; sent < presses; sent++) {
+            if (!waitReceived(sent)) {
+                break;
+            }
+            // lets the previous release settle
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            const QString& id = ids[static_cast<qsizetype>(sent % static_cast<size_t>(ids.size()))];
+            const uint64_t now = os_gettime_ns();
+            run.sentNs[sent] = now;
+            mock.sendShortcut(id, true, monotonicMs(now));
+            mock.sendShortcut(id, false, monotonicMs(now));
+        }
+        waitReceived(sent);
+
+        QMetaObject::invokeMethod(&loop, &QEventLoop::quit, Qt::QueuedConnection);
+    });
+
+    loop.exec();
+    compositor.join();
+    activeRun.store(nullptr, std::memory_order_release);
+
+    LatencyResult result;
+    const size_t received = std::min(run.received.load(), sent);
+    for (size_t i = 0; i < received; i++) {
+        result.microseconds.push_back((run.receivedNs[i] - run.sentNs[i]) / 1000.0);
+    }
+    std::sort(result.microseconds.begin(), result.microseconds.end());
+    result.lost = presses - received;
+    return result;
+}
+
+// source hotkeys, which never have to wait for the UI thread when there is a dispatch thread
+static QStringList sourceHotkeyIds(const MockPortal& mock)
+{
+    QStringList ids;
+    for (const auto& [id, description] : mock.boundShortcuts()) {
+        if (description.endsWith(u"] Mute"_s) || description.endsWith(u"] Unmute"_s)) {
+            ids.append(id);
+        }
+    }
+    return ids;
+}
+
+static void reportLatency(MockPortal& mock, size_t presses)
+{
+    struct Mode
+    {
+        const char* name;
+        bool dedicatedThread;
+        bool frameAligned;
+    };
+    static const Mode modes[] = {
+        {"UI thread", false, false},
+        {"DedicatedDispatchThread", true, false},
+        {"FrameAlignedDispatch", false, true},
+    };
+
+    printf("Press to hotkey callback, %zu presses of source hotkeys in a %zu hotkey collection\n", presses, latencyHotkeys);
+    printf("%-24s %-8s %8s %8s %8s %8s %6s\n", "dispatch", "UI", "p50 us", "p90 us", "p99 us", "max us", "lost");
+
+    ObsStub::populate(ObsStub::forHotkeys(latencyHotkeys));
+
+    // a UI thread busy for 20 ms out of every 50, e.g. with a heavy dock
+    QTimer busyTimer;
+    QObject::connect(&busyTimer, &QTimer::timeout, []() {
+        QElapsedTimer busy;
+        busy.start();
+        while (busy.nsecsElapsed() < 20000000) {
+        }
+    });
+
+    for (const Mode& mode : modes) {
+        config_t* config = obs_frontend_get_user_config();
+        config_set_bool(config, "WaylandHotkeys", "DedicatedDispatchThread", mode.dedicatedThread);
+        config_set_bool(config, "WaylandHotkeys", "FrameAlignedDispatch", mode.frameAligned);
+
+        if (mode.frameAligned) {
+            ObsStub::startVideo(60);
+        }
+
+        {
+            BoundPortal portal;
+            const QStringList ids = sourceHotkeyIds(mock);
+
+            if (!portal.isReady() || ids.isEmpty()) {
+                printf("%-24s failed to bind\n", mode.name);
+            } else {
+                for (bool busy : {false, true}) {
+                    if (busy) {
+                        busyTimer.start(50);
+                    }
+                    const LatencyResult result = measureLatency(mock, ids, presses);
+                    busyTimer.stop();
+
+                    printf("%-24s %-8s %8.0f %8.0f %8.0f %8.0f %6zu\n",
+                           mode.name,
+                           busy ? "busy" : "idle",
+                           percentile(result.microseconds, 0.5),
+                           percentile(result.microseconds, 0.9),
+                           percentile(result.microseconds, 0.99),
+                           result.microseconds.empty() ? 0.0 : result.microseconds.back(),
+                           result.lost);
+                }
+            }
+        }
+
+        // the dispatcher removed its tick callback with the portal
+        if (mode.frameAligned) {
+            ObsStub::stopVideo();
+        }
+    }
+
+    config_t* config = obs_frontend_get_user_config();
+    config_set_bool(config, "WaylandHotkeys", "DedicatedDispatchThread", false);
+    config_set_bool(config, "WaylandHotkeys", "FrameAlignedDispatch", false);
+}
+
+static std::shared_ptr<const ShortcutRegistry> benchmarkRegistry(qsizetype count, int generation)
+{
+    auto registry = std::make_shared<ShortcutRegistry>();
+    for (qsizetype i = 0; i < count; i++) {
+        const QString name = u"benchmark_"_s + QString::number(i);
+        const QString description = u"Benchmark shortcut %1 (%2)"_s.arg(i).arg(generation);
+        registry->insert(name, description, ShortcutCategory::Hotkey, name, ShortcutAction::triggerHotkey(static_cast<obs_hotkey_id>(i), false));
+    }
+    registry->finalize();
+    return registry;
+}
+
+static void reportRoundTrips()
+{
+    printf("\nPortal round trips\n");
+
+    PortalSession session(QDBusConnection::sessionBus(), u"obs_portal_benchmark"_s);
+
+    QElapsedTimer timer;
+    timer.start();
+    session.create();
+    if (!waitFor([&session]() { return session.isCreated(); })) {
+        printf("CreateSession failed\n");
+        return;
+    }
+    printf("CreateSession %.3f ms\n", timer.nsecsElapsed() / 1e6);
+
+    printf("%10s %12s %12s %15s\n", "shortcuts", "bind ms", "min ms", "us / shortcut");
+
+    for (qsizetype count : bindCounts) {
+        std::vector<double> roundTrips;
+
+        for (int generation = 0; generation < 5; generation++) {
+            session.setShortcuts(ShortcutBindList{benchmarkRegistry(count, generation), nullptr});
+
+            bool finished = false;
+            uint response = 2;
+            const auto connection = QObject::connect(&session, &PortalSession::bindFinished, [&](uint result) {
+                finished = true;
+                response = result;
+            });
+
+            timer.start();
+            session.bind(QString());
+            const bool answered = waitFor([&finished]() { return finished; });
+            const double ms = timer.nsecsElapsed() / 1e6;
+            QObject::disconnect(connection);
+
+            if (!answered || response != 0) {
+                break;
+            }
+            roundTrips.push_back(ms);
+        }
+
+        if (roundTrips.empty()) {
+            printf("%10lld failed\n", static_cast<long long>(count));
+            continue;
+        }
+
+        const double bindMs = median(roundTrips);
+        printf("%10lld %12.3f %12.3f %15.2f\n",
+               static_cast<long long>(count),
+               bindMs,
+               *std::min_element(roundTrips.begin(), roundTrips.end()),
+               bindMs * 1000 / count);
+    }
+}
+
+static void reportRebuilds()
+{
+    printf("\nRebuilds against the portal\n");
+    printf("%9s %10s %16s %14s %18s %15s\n", "hotkeys", "shortcuts", "unchanged / s", "unchanged ms", "with bind / s", "with bind ms");
+
+    for (size_t hotkeys : rebuildHotkeys) {
+        const ObsStub::Sizes baseSizes = ObsStub::forHotkeys(hotkeys);
+        ObsStub::populate(baseSizes);
+
+        BoundPortal portal;
+        if (!portal.isReady()) {
+            printf("%9zu failed to bind\n", hotkeys);
+            continue;
+        }
+
+        // nothing changed, so nothing is sent
+        QElapsedTimer timer;
+        timer.start();
+        int unchanged = 0;
+        while (timer.elapsed() < 1000 || unchanged < 5) {
+            portal->updateShortcuts();
+            unchanged++;
+        }
+        const double unchangedMs = timer.nsecsElapsed() / 1e6 / unchanged;
+
+        // a scene is added or removed every time, so every rebuild is bound again
+        std::vector<double> boundMs;
+        for (int i = 0; i < 10; i++) {
+            ObsStub::Sizes sizes = baseSizes;
+            sizes.scenes += i % 2 == 0 ? 1 : 0;
+            ObsStub::populate(sizes);
+
+            const int binds = portal.binds();
+            timer.start();
+            portal->updateShortcuts();
+            if (!portal.waitForBind(binds)) {
+                break;
+            }
+            boundMs.push_back(timer.nsecsElapsed() / 1e6);
+        }
+        const double withBindMs = median(boundMs);
+
+        printf("%9zu %10lld %16.1f %14.3f %18.1f %15.3f\n",
+               hotkeys,
+               static_cast<long long>(portal->shortcuts()->size()),
+               1000 / unchangedMs,
+               unchangedMs,
+               withBindMs > 0 ? 1000 / withBindMs : 0.0,
+               withBindMs);
+
+        if (hotkeys == rebuildHotkeys[0]) {
+            bool received = false;
+            const auto connection = QObject::connect(portal.get(), &ShortcutsPortal::versionReceived, [&received](uint) {
+                received = true;
+            });
+            timer.start();
+            portal->probeVersion();
+            waitFor([&received]() { return received; });
+            const double versionMs = timer.nsecsElapsed() / 1e6;
+            QObject::disconnect(connection);
+
+            timer.start();
+            portal->configureShortcuts();
+            const double configureMs = timer.nsecsElapsed() / 1e6;
+
+            printf("%9s version probe %.3f ms, ConfigureShortcuts %.3f ms\n", "", versionMs, configureMs);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // before anything in Qt connects to the session bus
+    PrivateBus bus;
+    if (!bus.start()) {
+        fprintf(stderr, "Failed to start dbus-daemon\n");
+        return 1;
+    }
+    setenv("DBUS_SESSION_BUS_ADDRESS", bus.address().c_str(), 1);
+    setenv("QT_QPA_PLATFORM", "offscreen", 0);
+
+    QApplication app(argc, argv);
+
+    size_t presses = defaultPresses;
+    if (argc > 1) {
+        presses = std::max<size_t>(strtoull(argv[1], nullptr, 10), 1);
+    }
+
+    QTemporaryDir configDir;
+    ObsStub::setConfigDir(configDir.path().toUtf8().constData());
+    ObsStub::setHotkeyCallback(onHotkey);
+
+    qDBusRegisterMetaType<std::pair<QString, QVariantMap>>();
+    qDBusRegisterMetaType<QList<QPair<QString, QVariantMap>>>();
+    qDBusRegisterMetaType<ShortcutBindList>();
+
+    // answers from its own thread, like a separate process would
+    auto* mock = new MockPortal(QString::fromStdString(bus.address()));
+    if (!mock->isRegistered()) {
+        fprintf(stderr, "Failed to register the mock portal\n");
+        delete mock;
+        return 1;
+    }
+
+    QThread mockThread;
+    mockThread.setObjectName(u"Mock portal"_s);
+    mock->moveToThread(&mockThread);
+    mockThread.start();
+
+    reportLatency(*mock, presses);
+    reportRoundTrips();
+    reportRebuilds();
+
+    mockThread.quit();
+    mockThread.wait();
+    delete mock;
+
+    ObsStub::setHotkeyCallback(nullptr);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "configFile.h"
+
+#include <obs-module.h>
+#include <util/bmem.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+
+using namespace Qt::Literals::StringLiterals;
+
+ConfigFile::ConfigFile(const char* fileName)
+    : m_fileName(fileName)
+{
+}
+
+bool ConfigFile::reload(QJsonObject& root)
+{
+    root = QJsonObject();
+
+    if (m_path.isEmpty()) {
+        char* path = obs_module_config_path(m_fileName);
+        m_path = QString::fromUtf8(path);
+        bfree(path);
+    }
+
+    const QFileInfo info(m_path);
+    if (!info.exists()) {
+        const bool removed = m_modified.isValid();
+        m_modified = QDateTime();
+        return removed;
+    }
+
+    if (info.lastModified() == m_modified) {
+        return false;
+    }
+    m_modified = info.lastModified();
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Failed to open %s", m_path.toUtf8().constData());
+        return true;
+    }
+
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Ignoring %s: %s at offset %d", m_path.toUtf8().constData(), error.errorString().toUtf8().constData(), error.offset);
+        return true;
+    }
+
+    root = document.object();
+    return true;
+}
+
+static bool isValidShortcutId(const QString& id)
+{
+    if (id.isEmpty()) {
+        return false;
+    }
+
+    for (QChar c : id) {
+        if (c.unicode() > 0x7f || !(c.isLetterOrNumber() || c == u'_')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readShortcutId(const QJsonObject& object, const char* kind, QSet<QString>& ids, QString& id)
+{
+    id = object.value(u"id"_s).toString();
+    if (!isValidShortcutId(id) || ids.contains(id)) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Skipping %s with missing, duplicate or invalid id '%s', only letters, digits and '_' are allowed", kind, id.toUtf8().constData());
+        return false;
+    }
+
+    ids.insert(id);
+    return true;
+}
+
+bool readTarget(const QJsonObject& object, TargetDefinition& target)
+{
+    if (object.contains(u"scene"_s)) {
+        target.kind = TargetDefinition::Kind::Scene;
+        target.name = object.value(u"scene"_s).toString();
+    } else if (object.contains(u"hotkey"_s)) {
+        target.kind = TargetDefinition::Kind::Hotkey;
+        target.name = object.value(u"hotkey"_s).toString();
+        target.owner = object.value(u"source"_s).toString();
+    } else if (object.contains(u"action"_s)) {
+        target.kind = TargetDefinition::Kind::Action;
+        target.name = object.value(u"action"_s).toString();
+    } else if (object.contains(u"macro"_s)) {
+        target.kind = TargetDefinition::Kind::Macro;
+        target.name = object.value(u"macro"_s).toString();
+    }
+
+    return !target.name.isEmpty();
+}
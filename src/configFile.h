@@ -0,0 +1,79 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QSet>
+#include <QString>
+
+// Something a macro step or a gesture acts on, written the same way in both files
+struct TargetDefinition
+{
+    enum class Kind {
+        // the scene with this name
+        Scene,
+        // a libobs hotkey by name, e.g. "libobs.unmute"
+        Hotkey,
+        // frontend action or built-in toggle id, e.g. "start_streaming"
+        Action,
+        // the macro with this id
+        Macro,
+    };
+
+    Kind kind = Kind::Action;
+    QString name;
+
+    // for hotkeys: the source, output... that registered it, empty for the frontend's own
+    QString owner;
+
+    bool isEmpty() const
+    {
+        return name.isEmpty();
+    }
+};
+
+// A JSON file in the plugin's config directory, only parsed again when it changed
+class ConfigFile
+{
+public:
+    explicit ConfigFile(const char* fileName);
+
+    // True if the file changed since the last call. root then holds its contents,
+    // which are empty if the file was removed or isn't valid JSON.
+    bool reload(QJsonObject& root);
+
+    const QString& path() const
+    {
+        return m_path;
+    }
+
+private:
+    const char* m_fileName;
+    QString m_path;
+    QDateTime m_modified;
+};
+
+// Reads the "id" of an entry, which becomes part of a portal shortcut id and has to be a
+// valid D-Bus object path element. Logs and returns false if it's missing, invalid or in ids.
+bool readShortcutId(const QJsonObject& object, const char* kind, QSet<QString>& ids, QString& id);
+
+// Reads {"scene": name}, {"hotkey": name, "source": owner}, {"action": name} or {"macro": id},
+// false if the object is none of them
+bool readTarget(const QJsonObject& object, TargetDefinition& target);
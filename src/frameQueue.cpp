@@ -0,0 +1,55 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "frameQueue.h"
+
+FrameQueue::FrameQueue(size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+
+    m_entries.resize(size);
+    m_mask = size - 1;
+}
+
+bool FrameQueue::push(Entry&& entry)
+{
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+        return false;
+    }
+
+    m_entries[tail & m_mask] = std::move(entry);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool FrameQueue::pop(Entry& entry)
+{
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    // moving out leaves the slot empty, so the registry isn't kept alive by the ring
+    entry = std::move(m_entries[head & m_mask]);
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,62 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include "shortcutRegistry.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Hands activations from the dispatcher to the OBS video thread, which applies them on
+// its next tick. Single producer, single consumer; lock free and allocation free once built.
+class FrameQueue
+{
+public:
+    struct Entry
+    {
+        // keeps the shortcut alive until the tick gets to it
+        std::shared_ptr<const ShortcutRegistry> registry;
+        int32_t index = 0;
+        bool pressed = false;
+        uint64_t timestamp = 0;
+        // os_gettime_ns() when the entry was queued
+        uint64_t queuedNs = 0;
+    };
+
+    // capacity is rounded up to a power of two
+    explicit FrameQueue(size_t capacity);
+
+    // Producer side, false if the queue is full
+    bool push(Entry&& entry);
+
+    // Consumer side, false if the queue is empty
+    bool pop(Entry& entry);
+
+private:
+    std::vector<Entry> m_entries;
+    size_t m_mask = 0;
+
+    // next entry to pop, only written by the consumer
+    alignas(64) std::atomic<size_t> m_head = 0;
+    // next entry to push, only written by the producer
+    alignas(64) std::atomic<size_t> m_tail = 0;
+};
@@ -0,0 +1,82 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "gestureFile.h"
+
+#include <obs-module.h>
+
+#include <QJsonArray>
+
+#include <algorithm>
+
+using namespace Qt::Literals::StringLiterals;
+
+static constexpr int defaultHoldMs = 300;
+static constexpr int defaultDoubleTapMs = 250;
+static constexpr int maxGestureMs = 10000;
+
+static uint32_t readMs(const QJsonObject& object, const QString& key, int fallback)
+{
+    return static_cast<uint32_t>(std::clamp(object.value(key).toInt(fallback), 1, maxGestureMs));
+}
+
+static void readGestureTarget(const QJsonObject& object, const QString& key, const QString& id, TargetDefinition& target)
+{
+    if (object.contains(key) && !readTarget(object.value(key).toObject(), target)) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Ignoring '%s' of gesture '%s' without scene, hotkey, action or macro", key.toUtf8().constData(), id.toUtf8().constData());
+    }
+}
+
+const QList<GestureDefinition>& GestureFile::load()
+{
+    QJsonObject root;
+    if (!m_file.reload(root)) {
+        return m_gestures;
+    }
+    m_gestures.clear();
+
+    const int holdMs = static_cast<int>(readMs(root, u"hold_ms"_s, defaultHoldMs));
+    const int doubleTapMs = static_cast<int>(readMs(root, u"double_tap_ms"_s, defaultDoubleTapMs));
+
+    QSet<QString> ids;
+    const QJsonArray gestures = root.value(u"gestures"_s).toArray();
+    for (const auto& value : gestures) {
+        const QJsonObject object = value.toObject();
+
+        GestureDefinition gesture;
+        if (!readShortcutId(object, "gesture", ids, gesture.id)) {
+            continue;
+        }
+
+        gesture.description = object.value(u"description"_s).toString();
+        if (gesture.description.isEmpty()) {
+            gesture.description = u"Gesture '%1'"_s.arg(gesture.id);
+        }
+
+        readGestureTarget(object, u"tap"_s, gesture.id, gesture.tap);
+        readGestureTarget(object, u"hold"_s, gesture.id, gesture.hold);
+        readGestureTarget(object, u"double_tap"_s, gesture.id, gesture.doubleTap);
+        gesture.holdMs = readMs(object, u"hold_ms"_s, holdMs);
+        gesture.doubleTapMs = readMs(object, u"double_tap_ms"_s, doubleTapMs);
+
+        m_gestures.append(gesture);
+    }
+
+    blog(LOG_INFO, "[ShortcutsPortal] Loaded %lld gestures from %s", static_cast<long long>(m_gestures.size()), m_file.path().toUtf8().constData());
+    return m_gestures;
+}
@@ -0,0 +1,58 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include "configFile.h"
+
+#include <QList>
+#include <QString>
+#include <cstdint>
+
+struct GestureDefinition
+{
+    // the shortcut is sent to the portal as "_gesture_<id>"
+    QString id;
+    QString description;
+
+    // what to run, empty if the gesture does nothing
+    TargetDefinition tap;
+    TargetDefinition hold;
+    TargetDefinition doubleTap;
+
+    uint32_t holdMs = 0;
+    uint32_t doubleTapMs = 0;
+};
+
+// User defined gestures, read from gestures.json in the plugin's config directory.
+// The file is only parsed again when it changed.
+class GestureFile
+{
+public:
+    const QList<GestureDefinition>& load();
+
+    // what the last load() returned
+    const QList<GestureDefinition>& gestures() const
+    {
+        return m_gestures;
+    }
+
+private:
+    ConfigFile m_file{"gestures.json"};
+    QList<GestureDefinition> m_gestures;
+};
@@ -0,0 +1,142 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "identityRegistry.h"
+
+#include <obs-module.h>
+#include <util/bmem.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <algorithm>
+
+using namespace Qt::Literals::StringLiterals;
+
+IdentityRegistry::~IdentityRegistry()
+{
+    save();
+}
+
+void IdentityRegistry::load(const QString& collection)
+{
+    if (collection == m_collection && !m_path.isEmpty()) {
+        return;
+    }
+
+    save();
+
+    m_collection = collection;
+    m_ids.clear();
+    m_usedIds.clear();
+    m_nextNumber = 1;
+    m_dirty = false;
+
+    // collection names can contain anything, keep the file name safe
+    const QString fileName = u"identities/"_s + QCryptographicHash::hash(collection.toUtf8(), QCryptographicHash::Md5).toHex() + u".json"_s;
+    char* path = obs_module_config_path(fileName.toUtf8().constData());
+    m_path = QString::fromUtf8(path);
+    bfree(path);
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    const QJsonObject ids = root.value(u"ids"_s).toObject();
+    for (auto it = ids.constBegin(); it != ids.constEnd(); ++it) {
+        const QString id = it.value().toString();
+        m_ids.insert(it.key(), id);
+        m_usedIds.insert(id);
+    }
+    m_nextNumber = std::max<uint64_t>(1, root.value(u"next"_s).toInteger());
+
+    blog(LOG_INFO, "[ShortcutsPortal] Loaded %lld shortcut identities for collection '%s'", static_cast<long long>(m_ids.size()), collection.toUtf8().constData());
+}
+
+void IdentityRegistry::save()
+{
+    if (!m_dirty || m_path.isEmpty()) {
+        return;
+    }
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    QJsonObject ids;
+    for (auto it = m_ids.constBegin(); it != m_ids.constEnd(); ++it) {
+        ids.insert(it.key(), it.value());
+    }
+
+    QJsonObject root;
+    root.insert(u"collection"_s, m_collection);
+    root.insert(u"next"_s, static_cast<qint64>(m_nextNumber));
+    root.insert(u"ids"_s, ids);
+
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) < 0 || !file.commit()) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Failed to save shortcut identities to %s", m_path.toUtf8().constData());
+        return;
+    }
+
+    m_dirty = false;
+}
+
+QString IdentityRegistry::hotkeyId(const QString& key, uint64_t preferredNumber)
+{
+    auto it = m_ids.constFind(key);
+    if (it != m_ids.constEnd()) {
+        return *it;
+    }
+
+    QString id = u"hk_"_s + QString::number(preferredNumber);
+    while (m_usedIds.contains(id)) {
+        id = u"hk_"_s + QString::number(m_nextNumber++);
+    }
+
+    m_nextNumber = std::max(m_nextNumber, preferredNumber + 1);
+    return allocate(key, id);
+}
+
+QString IdentityRegistry::sceneId(const QString& key, const QString& preferredId)
+{
+    auto it = m_ids.constFind(key);
+    if (it != m_ids.constEnd()) {
+        return *it;
+    }
+
+    QString id = preferredId;
+    while (m_usedIds.contains(id)) {
+        id = u"scene_"_s + QString::number(m_nextNumber++);
+    }
+
+    return allocate(key, id);
+}
+
+QString IdentityRegistry::allocate(const QString& key, const QString& id)
+{
+    m_ids.insert(key, id);
+    m_usedIds.insert(id);
+    m_dirty = true;
+    return id;
+}
@@ -0,0 +1,59 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <cstdint>
+
+// Maps what a shortcut acts on (registerer type, registerer UUID, hotkey name) to the
+// short id sent to the portal. Persisted per scene collection, so the portal sees the
+// same ids across restarts and source recreation and keeps the user's key bindings.
+class IdentityRegistry
+{
+public:
+    ~IdentityRegistry();
+
+    // Switches to the given scene collection, saving the previous one first
+    void load(const QString& collection);
+    void save();
+
+    const QString& collection() const
+    {
+        return m_collection;
+    }
+
+    // "hk_<n>", preferring the current libobs id so ids from older versions stay valid
+    QString hotkeyId(const QString& key, uint64_t preferredNumber);
+
+    // preferredId is used for new scenes if it isn't taken yet
+    QString sceneId(const QString& key, const QString& preferredId);
+
+private:
+    QString allocate(const QString& key, const QString& id);
+
+    QString m_collection;
+    QString m_path;
+
+    QHash<QString, QString> m_ids;
+    QSet<QString> m_usedIds;
+    uint64_t m_nextNumber = 1;
+    bool m_dirty = false;
+};
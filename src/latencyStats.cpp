@@ -0,0 +1,247 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "latencyStats.h"
+
+#include <algorithm>
+#include <ctime>
+
+using namespace Qt::Literals::StringLiterals;
+
+// anything older than this is more likely a clock mismatch than a real delay
+static constexpr int64_t maxPlausibleDelayUs = 60 * 1000 * 1000;
+
+static const char* categoryNames[] = {"Hotkeys", "Toggles", "Scenes", "Macros", "Gestures"};
+
+size_t LatencyHistogram::bucketIndex(uint64_t value)
+{
+    value = std::min(value, (uint64_t(1) << maxExponent) - 1);
+
+    if (value < subBucketCount) {
+        return static_cast<size_t>(value);
+    }
+
+    // value is at least subBucketCount here, so never 0
+    const int exponent = 63 - __builtin_clzll(value);
+    const int shift = exponent - subBucketBits;
+    const uint64_t subBucket = (value >> shift) - subBucketCount;
+    return static_cast<size_t>(subBucketCount + shift * subBucketCount + subBucket);
+}
+
+uint64_t LatencyHistogram::bucketValue(size_t index)
+{
+    if (index < subBucketCount) {
+        return index;
+    }
+
+    const size_t shift = (index - subBucketCount) / subBucketCount;
+    const uint64_t subBucket = (index - subBucketCount) % subBucketCount;
+
+    // report the middle of the bucket
+    const uint64_t lower = (subBucketCount + subBucket) << shift;
+    return lower + ((uint64_t(1) << shift) >> 1);
+}
+
+void LatencyHistogram::record(uint64_t valueUs)
+{
+    m_buckets[bucketIndex(valueUs)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t currentMax = m_max.load(std::memory_order_relaxed);
+    while (valueUs > currentMax && !m_max.compare_exchange_weak(currentMax, valueUs, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::max() const
+{
+    return m_max.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const
+{
+    const uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(total * percent / 100.0 + 0.5));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucketCount; i++) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucketValue(i), max());
+        }
+    }
+
+    return max();
+}
+
+void LatencyStats::recordActivation(ShortcutCategory category, int64_t delayUs, uint64_t execUs)
+{
+    CategoryStats& stats = m_categories[static_cast<size_t>(category)];
+
+    if (delayUs >= 0) {
+        stats.delay.record(static_cast<uint64_t>(delayUs));
+    } else {
+        stats.unknownDelay.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    stats.exec.record(execUs);
+}
+
+void LatencyStats::recordDropped(DroppedEvent reason)
+{
+    m_dropped[static_cast<size_t>(reason)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyStats::recordFrameWait(uint64_t waitUs)
+{
+    m_frameWait.record(waitUs);
+}
+
+void LatencyStats::reset()
+{
+    m_frameWait.reset();
+
+    for (auto& dropped : m_dropped) {
+        dropped.store(0, std::memory_order_relaxed);
+    }
+
+    for (auto& stats : m_categories) {
+        stats.delay.reset();
+        stats.exec.reset();
+        stats.unknownDelay.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t LatencyStats::sampleCount() const
+{
+    uint64_t total = 0;
+    for (const auto& stats : m_categories) {
+        total += stats.exec.count();
+    }
+    return total;
+}
+
+static QString formatUs(uint64_t us)
+{
+    return us >= 10000 ? QString::number(us / 1000.0, 'f', 1) + u" ms"_s : QString::number(us) + u" us"_s;
+}
+
+static QString formatHistogram(const LatencyHistogram& histogram)
+{
+    if (histogram.count() == 0) {
+        return u"no samples"_s;
+    }
+
+    return u"p50 %1, p90 %2, p99 %3, max %4"_s.arg(
+        formatUs(histogram.percentile(50)),
+        formatUs(histogram.percentile(90)),
+        formatUs(histogram.percentile(99)),
+        formatUs(histogram.max())
+    );
+}
+
+QString LatencyStats::summary() const
+{
+    QString text;
+
+    for (size_t i = 0; i < categoryCount; i++) {
+        const CategoryStats& stats = m_categories[i];
+        if (stats.exec.count() == 0) {
+            continue;
+        }
+
+        text += u"%1: %2 activations\n"_s.arg(QString::fromUtf8(categoryNames[i])).arg(stats.exec.count());
+        text += u"  compositor to callback: %1"_s.arg(formatHistogram(stats.delay));
+
+        const uint64_t unknown = stats.unknownDelay.load(std::memory_order_relaxed);
+        if (unknown > 0) {
+            text += u" (%1 without usable timestamp)"_s.arg(unknown);
+        }
+
+        text += u"\n  callback execution: %1\n"_s.arg(formatHistogram(stats.exec));
+    }
+
+    if (m_frameWait.count() > 0) {
+        text += u"Waiting for the next video frame: %1\n"_s.arg(formatHistogram(m_frameWait));
+    }
+
+    const uint64_t reordered = m_dropped[static_cast<size_t>(DroppedEvent::Reordered)].load(std::memory_order_relaxed);
+    const uint64_t duplicates = m_dropped[static_cast<size_t>(DroppedEvent::Duplicate)].load(std::memory_order_relaxed);
+    const uint64_t stalePairs = m_dropped[static_cast<size_t>(DroppedEvent::StalePair)].load(std::memory_order_relaxed);
+    if (reordered > 0 || duplicates > 0 || stalePairs > 0) {
+        text += u"Dropped events: %1 out of order, %2 duplicate, %3 stale press/release pairs\n"_s.arg(reordered).arg(duplicates).arg(stalePairs);
+    }
+
+    return text.isEmpty() ? u"No shortcut activations recorded yet.\n"_s : text;
+}
+
+int64_t LatencyStats::compositorDelayUs(uint64_t timestamp)
+{
+    if (timestamp == 0) {
+        return -1;
+    }
+
+    timespec realtime;
+    timespec monotonic;
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    clock_gettime(CLOCK_MONOTONIC, &monotonic);
+
+    const int64_t nowUs[] = {
+        int64_t(realtime.tv_sec) * 1000000 + realtime.tv_nsec / 1000,
+        int64_t(monotonic.tv_sec) * 1000000 + monotonic.tv_nsec / 1000,
+    };
+
+    // Backends don't agree on the clock (KDE sends wall clock milliseconds, others
+    // use the compositor's monotonic event time), pick the interpretation that makes sense
+    int64_t best = -1;
+    for (int64_t now : nowUs) {
+        for (int64_t scale : {int64_t(1000), int64_t(1)}) {
+            if (timestamp > uint64_t(INT64_MAX / scale)) {
+                continue;
+            }
+
+            // timestamps are truncated to milliseconds so they can be slightly ahead of us
+            const int64_t delay = now - int64_t(timestamp) * scale;
+            if (delay >= -1000 && delay < maxPlausibleDelayUs) {
+                const int64_t clamped = std::max<int64_t>(delay, 0);
+                if (best < 0 || clamped < best) {
+                    best = clamped;
+                }
+            }
+        }
+    }
+
+    return best;
+}
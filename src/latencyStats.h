@@ -0,0 +1,96 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include "shortcutRegistry.h"
+
+#include <QString>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Log-linear histogram in the spirit of HdrHistogram: values below 32 are exact,
+// above that every power of two is split in 32 buckets (~3% precision).
+// Recording is lock free and allocation free so it can happen on any thread.
+class LatencyHistogram
+{
+public:
+    void record(uint64_t valueUs);
+    void reset();
+
+    uint64_t count() const;
+    uint64_t max() const;
+    uint64_t percentile(double percent) const;
+
+private:
+    static constexpr int subBucketBits = 5;
+    static constexpr uint64_t subBucketCount = 1 << subBucketBits;
+    static constexpr int maxExponent = 36;
+    static constexpr size_t bucketCount = subBucketCount + (maxExponent - subBucketBits) * subBucketCount;
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketValue(size_t index);
+
+    std::array<std::atomic<uint64_t>, bucketCount> m_buckets {};
+    std::atomic<uint64_t> m_count = 0;
+    std::atomic<uint64_t> m_max = 0;
+};
+
+// Activation latency per shortcut category:
+// how long after the compositor saw the key the callback started, and how long it ran
+class LatencyStats
+{
+public:
+    enum class DroppedEvent {
+        // older than the last event applied for the same shortcut
+        Reordered,
+        // same state as the one already applied
+        Duplicate,
+        // stale press/release pair that arrived together, counted once per pair
+        StalePair,
+    };
+
+    void recordActivation(ShortcutCategory category, int64_t delayUs, uint64_t execUs);
+    void recordDropped(DroppedEvent reason);
+
+    // time an activation waited for the next video tick, see PluginSettings::frameAlignedDispatch
+    void recordFrameWait(uint64_t waitUs);
+    void reset();
+
+    uint64_t sampleCount() const;
+
+    QString summary() const;
+
+    // Delay between the portal timestamp and now, or -1 if the timestamp can't be interpreted
+    static int64_t compositorDelayUs(uint64_t timestamp);
+
+private:
+    static constexpr size_t categoryCount = 5;
+
+    struct CategoryStats
+    {
+        LatencyHistogram delay;
+        LatencyHistogram exec;
+        std::atomic<uint64_t> unknownDelay = 0;
+    };
+
+    std::array<CategoryStats, categoryCount> m_categories;
+    std::array<std::atomic<uint64_t>, 3> m_dropped {};
+    LatencyHistogram m_frameWait;
+};
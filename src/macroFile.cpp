@@ -0,0 +1,65 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "macroFile.h"
+
+#include <obs-module.h>
+
+#include <QJsonArray>
+
+using namespace Qt::Literals::StringLiterals;
+
+const QList<MacroDefinition>& MacroFile::load()
+{
+    QJsonObject root;
+    if (!m_file.reload(root)) {
+        return m_macros;
+    }
+    m_macros.clear();
+
+    QSet<QString> ids;
+    const QJsonArray macros = root.value(u"macros"_s).toArray();
+    for (const auto& value : macros) {
+        const QJsonObject object = value.toObject();
+
+        MacroDefinition macro;
+        if (!readShortcutId(object, "macro", ids, macro.id)) {
+            continue;
+        }
+
+        macro.description = object.value(u"description"_s).toString();
+        if (macro.description.isEmpty()) {
+            macro.description = u"Macro '%1'"_s.arg(macro.id);
+        }
+
+        const QJsonArray steps = object.value(u"steps"_s).toArray();
+        for (const auto& stepValue : steps) {
+            TargetDefinition step;
+            if (!readTarget(stepValue.toObject(), step)) {
+                blog(LOG_WARNING, "[ShortcutsPortal] Skipping a step of macro '%s' without scene, hotkey or action", macro.id.toUtf8().constData());
+                continue;
+            }
+            macro.steps.append(step);
+        }
+
+        m_macros.append(macro);
+    }
+
+    blog(LOG_INFO, "[ShortcutsPortal] Loaded %lld macros from %s", static_cast<long long>(m_macros.size()), m_file.path().toUtf8().constData());
+    return m_macros;
+}
@@ -0,0 +1,44 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include "configFile.h"
+
+#include <QList>
+#include <QString>
+
+struct MacroDefinition
+{
+    // the shortcut is sent to the portal as "_macro_<id>"
+    QString id;
+    QString description;
+    QList<TargetDefinition> steps;
+};
+
+// User defined macros, read from macros.json in the plugin's config directory.
+// The file is only parsed again when it changed.
+class MacroFile
+{
+public:
+    const QList<MacroDefinition>& load();
+
+private:
+    ConfigFile m_file{"macros.json"};
+    QList<MacroDefinition> m_macros;
+};
@@ -17,6 +17,7 @@
 */
 
 #include "src/shortcutsPortal.h"
+#include "src/statsDialog.h"
 
 #include <obs-frontend-api.h>
 #include <obs-module.h>
@@ -42,15 +43,27 @@ void obs_module_post_load()
     portal = new ShortcutsPortal();
     QMainWindow* mainWindow = static_cast<QMainWindow*>(obs_frontend_get_main_window());
     portal->setWindow(mainWindow);
-    portal->createSession();
 
-    if (portal->getVersion() >= 2) {
+    QObject::connect(portal, &ShortcutsPortal::versionReceived, portal, [](uint version) {
+        if (version < 2)
+            return;
+
         QAction* action = (QAction*)obs_frontend_add_tools_menu_qaction("Configure Wayland Hotkeys");
 
         QObject::connect(action, &QAction::triggered, []() {
             portal->configureShortcuts();
         });
-    }
+    });
+
+    QAction* statsAction = (QAction*)obs_frontend_add_tools_menu_qaction("Wayland Hotkeys statistics");
+    QObject::connect(statsAction, &QAction::triggered, [mainWindow]() {
+        auto* dialog = new StatsDialog(portal->stats(), mainWindow);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        dialog->show();
+    });
+
+    portal->createSession();
+    portal->probeVersion();
 }
 
 void obs_module_unload(void)
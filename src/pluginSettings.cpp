@@ -0,0 +1,54 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "pluginSettings.h"
+
+#include <obs-frontend-api.h>
+#include <util/config-file.h>
+
+#include <algorithm>
+#include <limits>
+
+static const char* configSection = "WaylandHotkeys";
+
+PluginSettings PluginSettings::load()
+{
+    PluginSettings settings;
+
+    config_t* config = obs_frontend_get_user_config();
+    if (!config) {
+        return settings;
+    }
+
+    config_set_default_bool(config, configSection, "DedicatedDispatchThread", settings.dedicatedDispatchThread);
+    settings.dedicatedDispatchThread = config_get_bool(config, configSection, "DedicatedDispatchThread");
+
+    config_set_default_int(config, configSection, "BindChunkSize", settings.bindChunkSize);
+    settings.bindChunkSize = static_cast<int>(std::clamp<int64_t>(config_get_int(config, configSection, "BindChunkSize"), 0, std::numeric_limits<int>::max()));
+
+    config_set_default_bool(config, configSection, "SessionPerCategory", settings.sessionPerCategory);
+    settings.sessionPerCategory = config_get_bool(config, configSection, "SessionPerCategory");
+
+    config_set_default_bool(config, configSection, "TriggerSocket", settings.triggerSocket);
+    settings.triggerSocket = config_get_bool(config, configSection, "TriggerSocket");
+
+    config_set_default_bool(config, configSection, "FrameAlignedDispatch", settings.frameAlignedDispatch);
+    settings.frameAlignedDispatch = config_get_bool(config, configSection, "FrameAlignedDispatch");
+
+    return settings;
+}
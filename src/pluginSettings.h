@@ -0,0 +1,44 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+// Advanced options, read from the [WaylandHotkeys] section of the OBS user config
+struct PluginSettings
+{
+    // Receive portal signals on a private bus connection handled by a dedicated thread,
+    // so hotkeys keep working while the OBS UI thread is busy
+    bool dedicatedDispatchThread = false;
+
+    // Split sets with more shortcuts than this across several portal sessions, bound one
+    // after the other starting with toggles, push-to-talk and scenes. 0 binds everything at once.
+    int bindChunkSize = 0;
+
+    // Give toggles, scenes, source hotkeys and the remaining hotkeys a session each, so a
+    // change to one of them doesn't rebind the others
+    bool sessionPerCategory = false;
+
+    // Accept press/release/list requests on a UNIX socket in the user's runtime directory,
+    // see TriggerSocket
+    bool triggerSocket = false;
+
+    // Apply activations at the start of the next video frame instead of as soon as they arrive
+    bool frameAlignedDispatch = false;
+
+    static PluginSettings load();
+};
@@ -0,0 +1,476 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "portalSession.h"
+
+#include <obs.h>
+
+#include <QDBusPendingCallWatcher>
+
+using namespace Qt::Literals::StringLiterals;
+
+static const QString freedesktopDest = u"org.freedesktop.portal.Desktop"_s;
+static const QString freedesktopPath = u"/org/freedesktop/portal/desktop"_s;
+static const QString globalShortcutsInterface = u"org.freedesktop.portal.GlobalShortcuts"_s;
+
+qsizetype ShortcutBindList::size() const
+{
+    if (indices) {
+        return static_cast<qsizetype>(indices->size());
+    }
+    return registry ? registry->size() : 0;
+}
+
+qsizetype ShortcutBindList::at(qsizetype position) const
+{
+    return indices ? (*indices)[position] : position;
+}
+
+bool ShortcutBindList::sameShortcuts(const ShortcutBindList& other) const
+{
+    if (size() != other.size()) {
+        return false;
+    }
+
+    if (registry == other.registry && indices == other.indices) {
+        return true;
+    }
+
+    for (qsizetype i = 0; i < size(); i++) {
+        const qsizetype index = at(i);
+        const qsizetype otherIndex = other.at(i);
+        if (registry->name(index) != other.registry->name(otherIndex) ||
+            registry->description(index) != other.registry->description(otherIndex)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static QString rawString(QStringView text)
+{
+    // only used while marshalling, the registry outlives the message
+    return QString::fromRawData(reinterpret_cast<const QChar*>(text.utf16()), text.size());
+}
+
+QDBusArgument& operator<<(QDBusArgument& argument, const ShortcutBindList& list)
+{
+    static const QString descriptionKey = u"description"_s;
+
+    // QtDBus also marshals a default constructed value to learn the signature
+    const qsizetype count = list.size();
+
+    argument.beginArray(QMetaType::fromType<std::pair<QString, QVariantMap>>());
+    for (qsizetype i = 0; i < count; i++) {
+        const qsizetype index = list.at(i);
+
+        argument.beginStructure();
+        argument << rawString(list.registry->name(index));
+
+        argument.beginMap(QMetaType::fromType<QString>(), QMetaType::fromType<QDBusVariant>());
+        argument.beginMapEntry();
+        argument << descriptionKey << QDBusVariant(rawString(list.registry->description(index)));
+        argument.endMapEntry();
+        argument.endMap();
+
+        argument.endStructure();
+    }
+    argument.endArray();
+
+    return argument;
+}
+
+const QDBusArgument& operator>>(const QDBusArgument& argument, ShortcutBindList&)
+{
+    // only ever sent, QtDBus just needs both directions to register the type
+    return argument;
+}
+
+PortalSession::PortalSession(const QDBusConnection& bus, const QString& token, QObject* parent)
+    : QObject(parent)
+    , m_bus(bus)
+    , m_token(token)
+{
+}
+
+PortalSession::~PortalSession()
+{
+    if (isCreating()) {
+        disconnectSessionResponse();
+    }
+
+    if (isBinding()) {
+        disconnectBindResponse();
+    }
+
+    if (isCreated()) {
+        disconnectClosed();
+
+        QDBusMessage close = QDBusMessage::createMethodCall(
+            freedesktopDest,
+            m_handle.path(),
+            u"org.freedesktop.portal.Session"_s,
+            u"Close"_s
+        );
+        m_bus.asyncCall(close);
+    }
+}
+
+void PortalSession::create()
+{
+    QDBusMessage createSessionCall = QDBusMessage::createMethodCall(
+        freedesktopDest,
+        freedesktopPath,
+        globalShortcutsInterface,
+        u"CreateSession"_s
+    );
+
+    QList<QVariant> createSessionArgs;
+
+    QMap<QString, QVariant> sessionOptions;
+    sessionOptions.insert(u"handle_token"_s, m_token);
+    sessionOptions.insert(u"session_handle_token"_s, m_token + u"_session"_s);
+    createSessionArgs.append(sessionOptions);
+    createSessionCall.setArguments(createSessionArgs);
+
+    this->m_responseHandle = QDBusObjectPath(requestPath(m_token));
+    connectSessionResponse();
+    m_sessionTimer.start();
+
+    const uint serial = ++m_createSerial;
+    auto* watcher = new QDBusPendingCallWatcher(m_bus.asyncCall(createSessionCall), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, serial](QDBusPendingCallWatcher* watcher) {
+        watcher->deleteLater();
+
+        if (serial != m_createSerial) {
+            return;
+        }
+
+        QDBusPendingReply<QDBusObjectPath> reply = *watcher;
+        if (reply.isError()) {
+            disconnectSessionResponse();
+            blog(LOG_ERROR, "[ShortcutsPortal] Failed to create global shortcuts session %s: %s", m_token.toUtf8().constData(), reply.error().message().toUtf8().constData());
+            failCreate(reply.error().message());
+            return;
+        }
+
+        blog(LOG_INFO, "[ShortcutsPortal] CreateSession %s replied after %lld ms", m_token.toUtf8().constData(), static_cast<long long>(m_sessionTimer.elapsed()));
+
+        if (reply.value() != m_responseHandle) {
+            disconnectSessionResponse();
+            this->m_responseHandle = reply.value();
+            connectSessionResponse();
+        }
+    });
+}
+
+void PortalSession::onCreateSessionResponse(uint response, const QVariantMap& results)
+{
+    disconnectSessionResponse();
+
+    if (response != 0) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Session %s was refused after %lld ms (response %u)", m_token.toUtf8().constData(), static_cast<long long>(m_sessionTimer.elapsed()), response);
+        failCreate(u"The portal refused to create the session (response %1)"_s.arg(response));
+        return;
+    }
+
+    if (!results.contains(u"session_handle"_s)) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Session creation response did not contain session_handle");
+        failCreate(u"The portal did not return a session handle"_s);
+        return;
+    }
+
+    m_createFailures = 0;
+    this->m_handle = QDBusObjectPath(results[u"session_handle"_s].toString());
+    connectClosed();
+    blog(LOG_INFO, "[ShortcutsPortal] Session %s created after %lld ms", m_token.toUtf8().constData(), static_cast<long long>(m_sessionTimer.elapsed()));
+
+    Q_EMIT created();
+}
+
+void PortalSession::failCreate(const QString& message)
+{
+    m_responseHandle = QDBusObjectPath();
+
+    // create() is retried, only bother the user the first time
+    if (m_createFailures++ == 0) {
+        Q_EMIT error(u"Failed to create global shortcuts session"_s, message);
+    }
+    Q_EMIT createFailed();
+}
+
+void PortalSession::onSessionClosed(const QVariantMap&)
+{
+    blog(LOG_WARNING, "[ShortcutsPortal] Session %s was closed by the portal", m_token.toUtf8().constData());
+
+    reset();
+    Q_EMIT closed();
+}
+
+void PortalSession::reset()
+{
+    if (isCreating()) {
+        disconnectSessionResponse();
+    }
+
+    if (isCreated()) {
+        disconnectClosed();
+    }
+
+    if (isBinding()) {
+        disconnectBindResponse();
+        m_bindRequestPath.clear();
+    }
+
+    m_createSerial++;
+    m_responseHandle = QDBusObjectPath();
+    m_handle = QDBusObjectPath();
+
+    // A new session starts out with nothing bound, the payload built for the last set is reused
+    m_pending = m_shortcuts.size() > 0;
+    m_sentValid = false;
+    m_accepted = false;
+}
+
+void PortalSession::setShortcuts(const ShortcutBindList& shortcuts)
+{
+    // A pending set hasn't reached the portal yet, otherwise compare with what it has.
+    // An empty set doesn't have to be sent to a session that never bound anything.
+    bool unchanged = m_pending ? shortcuts.sameShortcuts(m_shortcuts) : m_sentValid && shortcuts.sameShortcuts(m_sent);
+    if (!m_pending && !m_sentValid && !isBinding() && shortcuts.size() == 0) {
+        unchanged = true;
+    }
+
+    // The payload only references the registry, it is streamed from it when the message is sent
+    m_shortcuts = shortcuts;
+    m_payload = QVariant::fromValue(m_shortcuts);
+
+    if (unchanged) {
+        // same contents, don't keep the older registry alive
+        if (!m_pending) {
+            m_sent = shortcuts;
+        }
+        return;
+    }
+
+    // A newer set always wins, there is no point in letting the user confirm an outdated one
+    if (isBinding()) {
+        blog(LOG_INFO, "[ShortcutsPortal] Superseding in-flight bind request %u of %s", m_bindSerial, m_token.toUtf8().constData());
+        closeBindRequest();
+    }
+
+    m_pending = true;
+}
+
+void PortalSession::bind(const QString& windowId)
+{
+    QDBusMessage bindShortcuts = QDBusMessage::createMethodCall(
+        freedesktopDest,
+        freedesktopPath,
+        globalShortcutsInterface,
+        u"BindShortcuts"_s
+    );
+
+    m_pending = false;
+    m_sent = m_shortcuts;
+    m_sentValid = true;
+    m_accepted = false;
+
+    const uint serial = ++m_bindSerial;
+    const QString handleToken = m_token + u"_bind_"_s + QString::number(serial);
+
+    QMap<QString, QVariant> bindOptions;
+    bindOptions.insert(u"handle_token"_s, handleToken);
+
+    QList<QVariant> shortcutArgs;
+    shortcutArgs.append(m_handle);
+    shortcutArgs.append(m_payload);
+
+    shortcutArgs.append(windowId);
+    shortcutArgs.append(bindOptions);
+    bindShortcuts.setArguments(shortcutArgs);
+
+    const qsizetype count = m_shortcuts.size();
+
+    // Subscribe before calling so a fast Response can't slip through before we know the request path
+    m_bindRequestPath = requestPath(handleToken);
+    connectBindResponse();
+    m_bindTimer.start();
+
+    // asyncCall() marshals the message before returning
+    QDBusPendingCall call = m_bus.asyncCall(bindShortcuts);
+    const double marshalMs = m_bindTimer.nsecsElapsed() / 1e6;
+
+    auto* watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, serial, count, marshalMs](QDBusPendingCallWatcher* watcher) {
+        watcher->deleteLater();
+
+        if (serial != m_bindSerial || !isBinding()) {
+            return;
+        }
+
+        // The method reply is the portal's own cost, the Response may also include a user dialog
+        blog(LOG_INFO, "[ShortcutsPortal] BindShortcuts with %lld shortcuts on %s: marshalled and sent in %.2f ms, replied after %lld ms", static_cast<long long>(count), m_token.toUtf8().constData(), marshalMs, static_cast<long long>(m_bindTimer.elapsed()));
+
+        QDBusPendingReply<QDBusObjectPath> reply = *watcher;
+        if (reply.isError()) {
+            disconnectBindResponse();
+            m_bindRequestPath.clear();
+            m_sentValid = false;
+
+            blog(LOG_ERROR, "[ShortcutsPortal] Failed to bind shortcuts: %s", reply.error().message().toUtf8().constData());
+            Q_EMIT error(u"Failed to bind shortcuts"_s, reply.error().message());
+            Q_EMIT bindFinished(2);
+            return;
+        }
+
+        // Older portal versions don't use the handle token to build the request path
+        if (reply.value().path() != m_bindRequestPath) {
+            disconnectBindResponse();
+            m_bindRequestPath = reply.value().path();
+            connectBindResponse();
+        }
+    });
+}
+
+void PortalSession::onBindShortcutsResponse(uint response, const QVariantMap& results, const QDBusMessage& message)
+{
+    if (message.path() != m_bindRequestPath) {
+        return;
+    }
+
+    disconnectBindResponse();
+    m_bindRequestPath.clear();
+
+    const qint64 elapsed = m_bindTimer.elapsed();
+
+    if (response == 0) {
+        auto bound = qdbus_cast<QList<QPair<QString, QVariantMap>>>(results.value(u"shortcuts"_s));
+        blog(LOG_INFO, "[ShortcutsPortal] Bound %lld of %lld shortcuts on %s in %lld ms", static_cast<long long>(bound.size()), static_cast<long long>(m_sent.size()), m_token.toUtf8().constData(), static_cast<long long>(elapsed));
+        m_accepted = true;
+    } else if (response == 1) {
+        blog(LOG_INFO, "[ShortcutsPortal] Binding shortcuts on %s was cancelled after %lld ms", m_token.toUtf8().constData(), static_cast<long long>(elapsed));
+    } else {
+        blog(LOG_WARNING, "[ShortcutsPortal] Binding shortcuts on %s failed after %lld ms (response %u)", m_token.toUtf8().constData(), static_cast<long long>(elapsed), response);
+
+        // make sure the next update tries again
+        m_sentValid = false;
+        response = 2;
+    }
+
+    Q_EMIT bindFinished(response);
+}
+
+QString PortalSession::requestPath(const QString& handleToken) const
+{
+    // https://flatpak.github.io/xdg-desktop-portal/docs/doc-org.freedesktop.portal.Request.html
+    QString sender = m_bus.baseService().mid(1);
+    sender.replace(u'.', u'_');
+
+    return u"/org/freedesktop/portal/desktop/request/"_s + sender + u'/' + handleToken;
+}
+
+void PortalSession::connectSessionResponse()
+{
+    m_bus.connect(
+        freedesktopDest,
+        m_responseHandle.path(),
+        u"org.freedesktop.portal.Request"_s,
+        u"Response"_s,
+        this,
+        SLOT(onCreateSessionResponse(uint, QVariantMap))
+    );
+}
+
+void PortalSession::disconnectSessionResponse()
+{
+    m_bus.disconnect(
+        freedesktopDest,
+        m_responseHandle.path(),
+        u"org.freedesktop.portal.Request"_s,
+        u"Response"_s,
+        this,
+        SLOT(onCreateSessionResponse(uint, QVariantMap))
+    );
+}
+
+void PortalSession::connectClosed()
+{
+    m_bus.connect(
+        freedesktopDest,
+        m_handle.path(),
+        u"org.freedesktop.portal.Session"_s,
+        u"Closed"_s,
+        this,
+        SLOT(onSessionClosed(QVariantMap))
+    );
+}
+
+void PortalSession::disconnectClosed()
+{
+    m_bus.disconnect(
+        freedesktopDest,
+        m_handle.path(),
+        u"org.freedesktop.portal.Session"_s,
+        u"Closed"_s,
+        this,
+        SLOT(onSessionClosed(QVariantMap))
+    );
+}
+
+void PortalSession::connectBindResponse()
+{
+    m_bus.connect(
+        freedesktopDest,
+        m_bindRequestPath,
+        u"org.freedesktop.portal.Request"_s,
+        u"Response"_s,
+        this,
+        SLOT(onBindShortcutsResponse(uint, QVariantMap, QDBusMessage))
+    );
+}
+
+void PortalSession::disconnectBindResponse()
+{
+    m_bus.disconnect(
+        freedesktopDest,
+        m_bindRequestPath,
+        u"org.freedesktop.portal.Request"_s,
+        u"Response"_s,
+        this,
+        SLOT(onBindShortcutsResponse(uint, QVariantMap, QDBusMessage))
+    );
+}
+
+void PortalSession::closeBindRequest()
+{
+    disconnectBindResponse();
+
+    QDBusMessage close = QDBusMessage::createMethodCall(
+        freedesktopDest,
+        m_bindRequestPath,
+        u"org.freedesktop.portal.Request"_s,
+        u"Close"_s
+    );
+    m_bus.asyncCall(close);
+
+    m_bindRequestPath.clear();
+}
+
+#include "moc_portalSession.cpp"
@@ -0,0 +1,187 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include "shortcutRegistry.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QtDBus/QtDBus>
+#include <memory>
+#include <vector>
+
+// a(sa{sv}) argument of BindShortcuts, marshalled straight from the registry
+struct ShortcutBindList
+{
+    std::shared_ptr<const ShortcutRegistry> registry;
+
+    // shortcuts to send, the whole registry if null
+    std::shared_ptr<const std::vector<int32_t>> indices;
+
+    qsizetype size() const;
+    qsizetype at(qsizetype position) const;
+
+    bool sameShortcuts(const ShortcutBindList& other) const;
+};
+Q_DECLARE_METATYPE(ShortcutBindList)
+
+QDBusArgument& operator<<(QDBusArgument& argument, const ShortcutBindList& list);
+const QDBusArgument& operator>>(const QDBusArgument& argument, ShortcutBindList& list);
+
+// One GlobalShortcuts session and the set of shortcuts bound to it.
+// BindShortcuts replaces everything a session has bound, so a set that is split up
+// needs a session per part. The session is closed when the object is destroyed.
+class PortalSession : public QObject
+{
+    Q_OBJECT
+public:
+    PortalSession(const QDBusConnection& bus, const QString& token, QObject* parent = nullptr);
+    ~PortalSession();
+
+    // Asynchronous, created() is emitted once the portal handed out the session
+    void create();
+
+    bool isCreated() const
+    {
+        return !m_handle.path().isEmpty();
+    }
+
+    bool isCreating() const
+    {
+        return !isCreated() && !m_responseHandle.path().isEmpty();
+    }
+
+    // failed CreateSession attempts in a row, 0 once the session was created
+    int createFailures() const
+    {
+        return m_createFailures;
+    }
+
+    // Forgets a session the portal no longer has, e.g. because it restarted. Nothing is
+    // sent to the portal; once create() succeeded again the last set has to be bound again.
+    void reset();
+
+    const QDBusObjectPath& handle() const
+    {
+        return m_handle;
+    }
+
+    const QString& token() const
+    {
+        return m_token;
+    }
+
+    // which part of the shortcuts the session holds, see ShortcutsPortal::planSessions()
+    const QString& key() const
+    {
+        return m_key;
+    }
+
+    void setKey(const QString& key)
+    {
+        m_key = key;
+    }
+
+    // Sets what the session should have bound. Nothing has to be sent if it matches the
+    // set sent last, otherwise an outdated request still waiting for a Response is dropped.
+    void setShortcuts(const ShortcutBindList& shortcuts);
+
+    qsizetype shortcutCount() const
+    {
+        return m_shortcuts.size();
+    }
+
+    // setShortcuts() changed the set and it hasn't been sent yet
+    bool needsBind() const
+    {
+        return m_pending;
+    }
+
+    bool isBinding() const
+    {
+        return !m_bindRequestPath.isEmpty();
+    }
+
+    // the portal accepted the current set, or there was never anything to bind
+    bool isBound() const
+    {
+        return !m_pending && !isBinding() && (m_accepted || (!m_sentValid && m_shortcuts.size() == 0));
+    }
+
+    void bind(const QString& windowId);
+
+Q_SIGNALS:
+    void created();
+
+    // CreateSession failed or the portal refused it, create() has to be called again
+    void createFailed();
+
+    // the portal closed the session on its own, it has already been reset()
+    void closed();
+
+    // response of the Request, 0 if the shortcuts were bound, 1 if the user cancelled, 2 on any failure
+    void bindFinished(uint response);
+
+    void error(const QString& title, const QString& message);
+
+public Q_SLOTS:
+    void onCreateSessionResponse(uint response, const QVariantMap& results);
+    void onSessionClosed(const QVariantMap& details);
+    void onBindShortcutsResponse(uint response, const QVariantMap& results, const QDBusMessage& message);
+
+private:
+    QString requestPath(const QString& handleToken) const;
+
+    void connectSessionResponse();
+    void disconnectSessionResponse();
+    void failCreate(const QString& message);
+
+    void connectClosed();
+    void disconnectClosed();
+
+    void connectBindResponse();
+    void disconnectBindResponse();
+    void closeBindRequest();
+
+    QDBusConnection m_bus;
+    const QString m_token;
+    QString m_key;
+
+    QDBusObjectPath m_responseHandle;
+    QDBusObjectPath m_handle;
+    QElapsedTimer m_sessionTimer;
+    // replies to an older CreateSession call are ignored after reset()
+    uint m_createSerial = 0;
+    int m_createFailures = 0;
+
+    ShortcutBindList m_shortcuts;
+    // BindShortcuts argument for m_shortcuts, reused until the set changes
+    QVariant m_payload;
+    bool m_pending = false;
+
+    // the set sent last, only valid if the portal didn't reject it
+    ShortcutBindList m_sent;
+    bool m_sentValid = false;
+    bool m_accepted = false;
+
+    // request object of the BindShortcuts call waiting for a Response, empty when idle
+    QString m_bindRequestPath;
+    uint m_bindSerial = 0;
+    QElapsedTimer m_bindTimer;
+};
@@ -0,0 +1,425 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "shortcutDispatcher.h"
+
+#include <obs.h>
+#include <util/platform.h>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <algorithm>
+#include <climits>
+
+// a press that reaches us this late together with its release is not worth replaying
+static constexpr int64_t staleEventThresholdUs = 250 * 1000;
+
+// activations waiting for the next frame, more than a few per frame would be unusual
+static constexpr size_t frameQueueCapacity = 256;
+
+ShortcutDispatcher::ShortcutDispatcher(std::shared_ptr<LatencyStats> stats, bool frameAligned, QObject* parent)
+    : QObject(parent)
+    , m_stats(std::move(stats))
+{
+    m_pending.reserve(64);
+
+    // a child, so it moves to the dispatcher's thread along with it
+    m_gestureTimer = new QTimer(this);
+    m_gestureTimer->setSingleShot(true);
+    m_gestureTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_gestureTimer, &QTimer::timeout, this, &ShortcutDispatcher::expireGestures);
+
+    if (frameAligned) {
+        m_frameQueue = std::make_unique<FrameQueue>(frameQueueCapacity);
+        obs_add_tick_callback(onTick, this);
+    }
+}
+
+ShortcutDispatcher::~ShortcutDispatcher()
+{
+    // returns once a tick that is already running is done with the queue
+    if (m_frameQueue) {
+        obs_remove_tick_callback(onTick, this);
+    }
+}
+
+void ShortcutDispatcher::setRegistry(std::shared_ptr<const ShortcutRegistry> registry)
+{
+    std::lock_guard lock(m_registryMutex);
+    m_registry = std::move(registry);
+}
+
+std::shared_ptr<const ShortcutRegistry> ShortcutDispatcher::registry()
+{
+    std::lock_guard lock(m_registryMutex);
+    return m_registry;
+}
+
+void ShortcutDispatcher::setSessionHandles(const QList<QDBusObjectPath>& sessionHandles)
+{
+    std::lock_guard lock(m_registryMutex);
+    m_sessionHandles = sessionHandles;
+}
+
+bool ShortcutDispatcher::isOwnSession(const QDBusObjectPath& sessionHandle)
+{
+    std::lock_guard lock(m_registryMutex);
+    return m_sessionHandles.contains(sessionHandle);
+}
+
+void ShortcutDispatcher::dispatch(QStringView shortcutName, bool pressed, uint64_t timestamp)
+{
+    enqueue(shortcutName, pressed, timestamp, false);
+}
+
+void ShortcutDispatcher::enqueue(QStringView shortcutName, bool pressed, uint64_t timestamp, bool posted)
+{
+    std::shared_ptr<const ShortcutRegistry> registry;
+    {
+        std::lock_guard lock(m_registryMutex);
+        registry = m_registry;
+    }
+
+    if (!registry) {
+        return;
+    }
+
+    const qsizetype index = registry->find(shortcutName);
+    if (index < 0) {
+        return;
+    }
+
+    // pending indices refer to the registry they were looked up in
+    if (registry != m_batchRegistry) {
+        flush();
+        resetGestures(registry.get());
+        m_batchRegistry = registry;
+        m_keyStates.assign(registry->size(), KeyState());
+    }
+
+    m_pending.push_back({static_cast<int32_t>(index), pressed, false, posted, timestamp});
+
+    // Runs after every event that is already queued, so a backlog ends up in one batch
+    if (!m_flushQueued) {
+        m_flushQueued = true;
+        QMetaObject::invokeMethod(this, &ShortcutDispatcher::flush, Qt::QueuedConnection);
+    }
+}
+
+void ShortcutDispatcher::post(const QString& shortcutName, bool pressed)
+{
+    QMetaObject::invokeMethod(this, [this, shortcutName, pressed]() {
+        enqueue(shortcutName, pressed, 0, true);
+    }, Qt::QueuedConnection);
+}
+
+void ShortcutDispatcher::flush()
+{
+    m_flushQueued = false;
+
+    if (m_pending.empty()) {
+        return;
+    }
+
+    // find presses whose release is already part of this batch
+    for (auto it = m_pending.rbegin(); it != m_pending.rend(); ++it) {
+        if (it->posted) {
+            continue;
+        }
+
+        KeyState& state = m_keyStates[it->index];
+        if (!it->pressed) {
+            state.releaseAhead = true;
+        } else if (state.releaseAhead) {
+            it->releaseFollows = true;
+            state.releaseAhead = false;
+        }
+    }
+
+    for (const PendingEvent& event : m_pending) {
+        // Posted events have no timestamp to order by and don't go through the key state,
+        // a client may well only send presses, e.g. to toggle recording twice
+        if (event.posted) {
+            execute(event.index, event.pressed, event.timestamp);
+            continue;
+        }
+
+        KeyState& state = m_keyStates[event.index];
+        state.releaseAhead = false;
+
+        if (event.timestamp != 0 && event.timestamp < state.lastTimestamp) {
+            m_stats->recordDropped(LatencyStats::DroppedEvent::Reordered);
+            continue;
+        }
+        state.lastTimestamp = std::max(state.lastTimestamp, event.timestamp);
+
+        if (!event.pressed && state.skipRelease) {
+            state.skipRelease = false;
+            continue;
+        }
+
+        // Replaying a press and release that both happened long ago would only make
+        // push-to-talk blip, the latest state (released) is what matters. Everything else,
+        // like starting a recording or a screenshot, is a one-shot action and always replayed.
+        if (event.pressed && event.releaseFollows && m_batchRegistry->isHoldHotkey(event.index)
+            && LatencyStats::compositorDelayUs(event.timestamp) > staleEventThresholdUs) {
+            state.skipRelease = true;
+            m_stats->recordDropped(LatencyStats::DroppedEvent::StalePair);
+            continue;
+        }
+
+        if (state.pressed == static_cast<int8_t>(event.pressed)) {
+            m_stats->recordDropped(LatencyStats::DroppedEvent::Duplicate);
+            continue;
+        }
+        state.pressed = static_cast<int8_t>(event.pressed);
+
+        execute(event.index, event.pressed, event.timestamp);
+    }
+
+    m_pending.clear();
+}
+
+void ShortcutDispatcher::execute(int32_t index, bool pressed, uint64_t timestamp)
+{
+    const int32_t gesture = m_batchRegistry->gestureSlot(index);
+    if (gesture >= 0) {
+        handleGesture(gesture, pressed, timestamp);
+        return;
+    }
+
+    // a full queue means the video thread is stalled, better run late than not at all
+    if (m_frameQueue && m_frameQueue->push({m_batchRegistry, index, pressed, timestamp, os_gettime_ns()})) {
+        return;
+    }
+
+    QCoreApplication* app = QCoreApplication::instance();
+    if (!m_batchRegistry->needsUiThread(index) || QThread::currentThread() == app->thread()) {
+        run(*m_batchRegistry, index, pressed, timestamp, *m_stats);
+        return;
+    }
+
+    runOnMainThread(m_batchRegistry, index, pressed, timestamp, m_stats);
+}
+
+void ShortcutDispatcher::runOnMainThread(std::shared_ptr<const ShortcutRegistry> registry, int32_t index, bool pressed, uint64_t timestamp, std::shared_ptr<LatencyStats> stats)
+{
+    // the registry reference keeps the shortcut alive until the main thread gets to it
+    QMetaObject::invokeMethod(QCoreApplication::instance(), [registry = std::move(registry), index, pressed, timestamp, stats = std::move(stats)]() {
+        run(*registry, index, pressed, timestamp, *stats);
+    }, Qt::QueuedConnection);
+}
+
+void ShortcutDispatcher::onTick(void* data, float)
+{
+    auto* dispatcher = static_cast<ShortcutDispatcher*>(data);
+
+    const uint64_t tickNs = os_gettime_ns();
+    FrameQueue::Entry entry;
+    while (dispatcher->m_frameQueue->pop(entry)) {
+        dispatcher->m_stats->recordFrameWait((tickNs - entry.queuedNs) / 1000);
+
+        // The frontend only switches scenes, toggles outputs and runs its own hotkeys on the
+        // UI thread, so those are released at the frame boundary but applied once the main
+        // thread gets to them. Running them here would also nest in libobs' tick callback loop.
+        if (!entry.registry->needsUiThread(entry.index)) {
+            run(*entry.registry, entry.index, entry.pressed, entry.timestamp, *dispatcher->m_stats);
+        } else {
+            runOnMainThread(std::move(entry.registry), entry.index, entry.pressed, entry.timestamp, dispatcher->m_stats);
+        }
+        entry.registry.reset();
+    }
+}
+
+void ShortcutDispatcher::run(const ShortcutRegistry& registry, int32_t index, bool pressed, uint64_t timestamp, LatencyStats& stats)
+{
+    const int64_t delayUs = LatencyStats::compositorDelayUs(timestamp);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    registry.trigger(index, pressed);
+
+    stats.recordActivation(registry.category(index), delayUs, static_cast<uint64_t>(timer.nsecsElapsed() / 1000));
+}
+
+// When the key event happened on the os_gettime_ns() clock, so a press and release that
+// were delivered late still measure how long the key was actually held
+static uint64_t eventTimeUs(uint64_t timestamp)
+{
+    const uint64_t nowUs = os_gettime_ns() / 1000;
+    const int64_t delayUs = LatencyStats::compositorDelayUs(timestamp);
+    return delayUs > 0 ? nowUs - std::min<uint64_t>(delayUs, nowUs) : nowUs;
+}
+
+void ShortcutDispatcher::pressAndRelease(int32_t index, uint64_t timestamp)
+{
+    if (index >= 0) {
+        execute(index, true, timestamp);
+        execute(index, false, timestamp);
+    }
+}
+
+void ShortcutDispatcher::handleGesture(int32_t slot, bool pressed, uint64_t timestamp)
+{
+    const ShortcutGesture& gesture = m_batchRegistry->gesture(slot);
+    GestureState& state = m_gestureStates[slot];
+    const uint64_t eventUs = eventTimeUs(timestamp);
+
+    switch (state.phase) {
+    case GestureState::Phase::Idle:
+        if (pressed) {
+            state.phase = GestureState::Phase::Down;
+            state.pressedUs = eventUs;
+            state.deadlineUs = gesture.hold >= 0 ? eventUs + gesture.holdMs * uint64_t(1000) : 0;
+        }
+        break;
+
+    case GestureState::Phase::Down: {
+        if (pressed) {
+            break;
+        }
+        state.deadlineUs = 0;
+
+        const uint64_t heldUs = eventUs > state.pressedUs ? eventUs - state.pressedUs : 0;
+        if (gesture.hold >= 0 && heldUs >= gesture.holdMs * uint64_t(1000)) {
+            // the timer didn't get to it, e.g. both events arrived late together
+            state.phase = GestureState::Phase::Idle;
+            pressAndRelease(gesture.hold, timestamp);
+        } else if (gesture.doubleTap >= 0) {
+            state.phase = GestureState::Phase::TapReleased;
+            state.deadlineUs = eventUs + gesture.doubleTapMs * uint64_t(1000);
+        } else {
+            state.phase = GestureState::Phase::Idle;
+            pressAndRelease(gesture.tap, timestamp);
+        }
+        break;
+    }
+
+    case GestureState::Phase::Holding:
+        if (!pressed) {
+            state.phase = GestureState::Phase::Idle;
+            execute(gesture.hold, false, timestamp);
+        }
+        break;
+
+    case GestureState::Phase::TapReleased:
+        if (pressed) {
+            state.phase = GestureState::Phase::SecondDown;
+            state.deadlineUs = 0;
+            pressAndRelease(gesture.doubleTap, timestamp);
+        }
+        break;
+
+    case GestureState::Phase::SecondDown:
+        if (!pressed) {
+            state.phase = GestureState::Phase::Idle;
+        }
+        break;
+    }
+
+    armGestureTimer();
+}
+
+void ShortcutDispatcher::expireGestures()
+{
+    const uint64_t nowUs = os_gettime_ns() / 1000;
+
+    for (size_t slot = 0; slot < m_gestureStates.size(); slot++) {
+        GestureState& state = m_gestureStates[slot];
+        if (state.deadlineUs == 0 || state.deadlineUs > nowUs) {
+            continue;
+        }
+        state.deadlineUs = 0;
+
+        const ShortcutGesture& gesture = m_batchRegistry->gesture(static_cast<int32_t>(slot));
+        if (state.phase == GestureState::Phase::Down) {
+            state.phase = GestureState::Phase::Holding;
+            execute(gesture.hold, true, 0);
+        } else if (state.phase == GestureState::Phase::TapReleased) {
+            state.phase = GestureState::Phase::Idle;
+            pressAndRelease(gesture.tap, 0);
+        }
+    }
+
+    armGestureTimer();
+}
+
+void ShortcutDispatcher::resetGestures(const ShortcutRegistry* next)
+{
+    // don't leave something like push-to-talk pressed forever
+    for (size_t slot = 0; slot < m_gestureStates.size(); slot++) {
+        if (m_gestureStates[slot].phase == GestureState::Phase::Holding) {
+            execute(m_batchRegistry->gesture(static_cast<int32_t>(slot)).hold, false, 0);
+        }
+    }
+
+    m_gestureStates.assign(next ? next->gestureCount() : 0, GestureState());
+    m_gestureTimer->stop();
+}
+
+void ShortcutDispatcher::armGestureTimer()
+{
+    uint64_t deadlineUs = 0;
+    for (const GestureState& state : m_gestureStates) {
+        if (state.deadlineUs != 0 && (deadlineUs == 0 || state.deadlineUs < deadlineUs)) {
+            deadlineUs = state.deadlineUs;
+        }
+    }
+
+    if (deadlineUs == 0) {
+        m_gestureTimer->stop();
+        return;
+    }
+
+    const uint64_t nowUs = os_gettime_ns() / 1000;
+    const uint64_t waitMs = deadlineUs > nowUs ? (deadlineUs - nowUs + 999) / 1000 : 0;
+    m_gestureTimer->start(static_cast<int>(std::min<uint64_t>(waitMs, INT_MAX)));
+}
+
+void ShortcutDispatcher::onActivatedSignal(
+    const QDBusObjectPath& sessionHandle,
+    const QString& shortcutName,
+    qulonglong timestamp,
+    const QVariantMap&
+)
+{
+    if (!isOwnSession(sessionHandle)) {
+        return;
+    }
+
+    dispatch(shortcutName, true, timestamp);
+}
+
+void ShortcutDispatcher::onDeactivatedSignal(
+    const QDBusObjectPath& sessionHandle,
+    const QString& shortcutName,
+    qulonglong timestamp,
+    const QVariantMap&
+)
+{
+    if (!isOwnSession(sessionHandle)) {
+        return;
+    }
+
+    dispatch(shortcutName, false, timestamp);
+}
+
+#include "moc_shortcutDispatcher.cpp"
@@ -0,0 +1,165 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include "frameQueue.h"
+#include "latencyStats.h"
+#include "shortcutRegistry.h"
+
+#include <QObject>
+#include <QTimer>
+#include <QtDBus/QtDBus>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Receives the portal Activated/Deactivated signals and runs the matching shortcut.
+// Lives on the main thread by default, or on a dedicated thread in which case
+// shortcuts that touch the UI are marshalled back to the main thread.
+//
+// Events are applied in batches: everything that piled up while the thread was busy is
+// ordered per shortcut by the portal timestamp, and stale push-to-talk/push-to-mute
+// press/release pairs are collapsed.
+//
+// When frame aligned, the resulting activations are queued for the next OBS video tick
+// instead of running right away: source, output, encoder and service hotkeys run on the
+// video thread at the start of the frame, shortcuts that touch the UI (including the
+// frontend's own hotkeys) are handed to the main thread from there.
+//
+// Gesture shortcuts don't run anything themselves: a small state machine per gesture
+// decides between tap, hold and double tap and runs the shortcut configured for it.
+// The only timer is armed while a gesture waits for its hold or double tap deadline.
+class ShortcutDispatcher : public QObject
+{
+    Q_OBJECT
+public:
+    ShortcutDispatcher(std::shared_ptr<LatencyStats> stats, bool frameAligned, QObject* parent = nullptr);
+    ~ShortcutDispatcher();
+
+    // Can be called from any thread, the registry must not be modified afterwards
+    void setRegistry(std::shared_ptr<const ShortcutRegistry> registry);
+
+    // The registry shortcuts are currently looked up in, can be called from any thread
+    std::shared_ptr<const ShortcutRegistry> registry();
+
+    // Sessions whose signals are accepted, anything else is ignored before the lookup.
+    // Can be called from any thread.
+    void setSessionHandles(const QList<QDBusObjectPath>& sessionHandles);
+
+    // timestamp is the one sent by the portal, 0 if unknown
+    void dispatch(QStringView shortcutName, bool pressed, uint64_t timestamp);
+
+    // dispatch() from any other thread, the event is queued to the dispatcher's thread.
+    // Posted events are applied as they come: never reordered, collapsed or dropped as duplicates.
+    void post(const QString& shortcutName, bool pressed);
+
+public Q_SLOTS:
+    void onActivatedSignal(
+        const QDBusObjectPath& sessionHandle,
+        const QString& shortcutName,
+        qulonglong timestamp,
+        const QVariantMap& options
+    );
+
+    void onDeactivatedSignal(
+        const QDBusObjectPath& sessionHandle,
+        const QString& shortcutName,
+        qulonglong timestamp,
+        const QVariantMap& options
+    );
+
+private:
+    struct PendingEvent
+    {
+        int32_t index;
+        bool pressed;
+        // a release of the same shortcut follows in the same batch
+        bool releaseFollows;
+        // from post(), bypasses the key state
+        bool posted;
+        uint64_t timestamp;
+    };
+
+    struct KeyState
+    {
+        uint64_t lastTimestamp = 0;
+        // -1 until the first event after a rebuild
+        int8_t pressed = -1;
+        bool releaseAhead = false;
+        bool skipRelease = false;
+    };
+
+    struct GestureState
+    {
+        enum class Phase : uint8_t {
+            Idle,
+            // pressed, turns into a hold at the deadline
+            Down,
+            // the hold shortcut is pressed until the key is released
+            Holding,
+            // released after a tap, pressing again before the deadline makes it a double tap
+            TapReleased,
+            // second press of a double tap, its release is ignored
+            SecondDown,
+        };
+
+        Phase phase = Phase::Idle;
+        // on the os_gettime_ns() clock in us, from the portal timestamp when it can be used
+        uint64_t pressedUs = 0;
+        // 0 while no timer is needed
+        uint64_t deadlineUs = 0;
+    };
+
+    bool isOwnSession(const QDBusObjectPath& sessionHandle);
+    void enqueue(QStringView shortcutName, bool pressed, uint64_t timestamp, bool posted);
+
+    void handleGesture(int32_t slot, bool pressed, uint64_t timestamp);
+    void expireGestures();
+    // releases held shortcuts before the gestures of another registry take over
+    void resetGestures(const ShortcutRegistry* next);
+    void armGestureTimer();
+    void pressAndRelease(int32_t index, uint64_t timestamp);
+
+    void flush();
+    void execute(int32_t index, bool pressed, uint64_t timestamp);
+
+    static void run(const ShortcutRegistry& registry, int32_t index, bool pressed, uint64_t timestamp, LatencyStats& stats);
+    static void runOnMainThread(std::shared_ptr<const ShortcutRegistry> registry, int32_t index, bool pressed, uint64_t timestamp, std::shared_ptr<LatencyStats> stats);
+
+    static void onTick(void* data, float seconds);
+
+    std::shared_ptr<LatencyStats> m_stats;
+
+    // only when frame aligned, filled on the dispatcher's thread and drained by onTick()
+    std::unique_ptr<FrameQueue> m_frameQueue;
+
+    std::mutex m_registryMutex;
+    std::shared_ptr<const ShortcutRegistry> m_registry;
+    QList<QDBusObjectPath> m_sessionHandles;
+
+    // only touched on the dispatcher's thread
+    std::shared_ptr<const ShortcutRegistry> m_batchRegistry;
+    std::vector<PendingEvent> m_pending;
+    std::vector<KeyState> m_keyStates;
+    bool m_flushQueued = false;
+
+    // by gesture slot of m_batchRegistry
+    std::vector<GestureState> m_gestureStates;
+    QTimer* m_gestureTimer = nullptr;
+};
@@ -0,0 +1,529 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "shortcutRegistry.h"
+
+#include <obs-frontend-api.h>
+#include <obs.hpp>
+#include <util/platform.h>
+
+#include <QByteArray>
+#include <QHash>
+
+#include <algorithm>
+#include <initializer_list>
+#include <numeric>
+
+// give up on a bucket after this many seeds and retry with a bigger table
+static constexpr size_t maxSeedAttempts = 1 << 16;
+
+// Slot of text in an open addressing table of indices, or the free slot where it belongs
+template<typename ViewOf>
+static size_t probeSlot(const std::vector<int32_t>& table, QStringView text, ViewOf viewOf)
+{
+    const size_t mask = table.size() - 1;
+    for (size_t slot = qHash(text, 0) & mask;; slot = (slot + 1) & mask) {
+        const int32_t entry = table[slot];
+        if (entry < 0 || viewOf(entry) == text) {
+            return slot;
+        }
+    }
+}
+
+// Keeps the table at most half full so probes stay short
+template<typename ViewOf>
+static void reserveSlot(std::vector<int32_t>& table, size_t count, ViewOf viewOf)
+{
+    if ((count + 1) * 2 <= table.size()) {
+        return;
+    }
+
+    table.assign(std::max<size_t>(64, table.size() * 2), -1);
+    for (size_t i = 0; i < count; i++) {
+        table[probeSlot(table, viewOf(static_cast<int32_t>(i)), viewOf)] = static_cast<int32_t>(i);
+    }
+}
+
+ShortcutRegistry::~ShortcutRegistry()
+{
+    clear();
+}
+
+void ShortcutRegistry::reserve(const ShortcutRegistry& previous)
+{
+    m_text.reserve(previous.m_text.size());
+    m_names.reserve(previous.m_names.size());
+    m_descriptions.reserve(previous.m_descriptions.size());
+    m_targets.reserve(previous.m_targets.size());
+    m_categories.reserve(previous.m_categories.size());
+    m_actions.reserve(previous.m_actions.size());
+    m_descriptionPool.reserve(previous.m_descriptionPool.size());
+    m_macroSteps.reserve(previous.m_macroSteps.size());
+    m_macroLabels.reserve(previous.m_macroLabels.size());
+    m_gestures.reserve(previous.m_gestures.size());
+    m_gestureTargets.reserve(previous.m_gestureTargets.size());
+}
+
+void ShortcutRegistry::clear()
+{
+    for (auto& action : m_actions) {
+        release(action);
+    }
+
+    for (auto& step : m_macroSteps) {
+        if (step.type == MacroStep::Type::Scene) {
+            obs_weak_source_release(step.scene);
+            step.scene = nullptr;
+        }
+    }
+
+    m_text.clear();
+    m_names.clear();
+    m_descriptions.clear();
+    m_targets.clear();
+    m_categories.clear();
+    m_actions.clear();
+    m_descriptionPool.clear();
+    m_macroSteps.clear();
+    m_macroLabels.clear();
+    m_macroStart = 0;
+    m_gestures.clear();
+    m_gestureTargets.clear();
+    m_nameIndex.clear();
+    m_descriptionIndex.clear();
+    m_resolvedHotkeys.reset();
+    m_numberSlots.clear();
+    m_bucketSeeds.clear();
+    m_hashSlots.clear();
+}
+
+void ShortcutRegistry::insert(QStringView name, QStringView description, ShortcutCategory category, QStringView target, ShortcutAction action)
+{
+    const auto nameOf = [this](int32_t index) {
+        return view(m_names[index]);
+    };
+    const auto descriptionOf = [this](int32_t index) {
+        return view(m_descriptionPool[index]);
+    };
+
+    reserveSlot(m_descriptionIndex, m_descriptionPool.size(), descriptionOf);
+    const size_t descriptionSlot = probeSlot(m_descriptionIndex, description, descriptionOf);
+    if (m_descriptionIndex[descriptionSlot] < 0) {
+        m_descriptionIndex[descriptionSlot] = static_cast<int32_t>(m_descriptionPool.size());
+        m_descriptionPool.push_back(store(description));
+    }
+    const auto descriptionId = static_cast<uint32_t>(m_descriptionIndex[descriptionSlot]);
+
+    reserveSlot(m_nameIndex, m_names.size(), nameOf);
+    const size_t nameSlot = probeSlot(m_nameIndex, name, nameOf);
+
+    const int32_t existing = m_nameIndex[nameSlot];
+    if (existing >= 0) {
+        release(m_actions[existing]);
+
+        m_descriptions[existing] = descriptionId;
+        m_targets[existing] = store(target);
+        m_categories[existing] = category;
+        m_actions[existing] = action;
+        return;
+    }
+
+    m_nameIndex[nameSlot] = static_cast<int32_t>(m_names.size());
+    m_names.push_back(store(name));
+    m_descriptions.push_back(descriptionId);
+    m_targets.push_back(store(target));
+    m_categories.push_back(category);
+    m_actions.push_back(action);
+}
+
+void ShortcutRegistry::addMacroStep(MacroStep step, QStringView label)
+{
+    m_macroSteps.push_back(step);
+    m_macroLabels.push_back(store(label));
+}
+
+ShortcutAction ShortcutRegistry::takeMacro()
+{
+    ShortcutAction action;
+    action.type = ShortcutAction::Type::Macro;
+    action.macro = {m_macroStart, static_cast<uint32_t>(m_macroSteps.size()) - m_macroStart};
+
+    m_macroStart = static_cast<uint32_t>(m_macroSteps.size());
+    return action;
+}
+
+ShortcutAction ShortcutRegistry::addGesture(GestureTarget tap, GestureTarget hold, GestureTarget doubleTap, uint32_t holdMs, uint32_t doubleTapMs)
+{
+    ShortcutGesture gesture;
+    gesture.holdMs = holdMs;
+    gesture.doubleTapMs = doubleTapMs;
+
+    ShortcutAction action;
+    action.type = ShortcutAction::Type::Gesture;
+    action.gesture = static_cast<uint32_t>(m_gestures.size());
+
+    m_gestures.push_back(gesture);
+    for (const GestureTarget& target : {tap, hold, doubleTap}) {
+        m_gestureTargets.push_back({target.category, store(target.target)});
+    }
+    return action;
+}
+
+void ShortcutRegistry::finalize()
+{
+    m_nameIndex = {};
+    m_descriptionIndex = {};
+    m_numberSlots.clear();
+
+    bool hasLazyHotkeys = false;
+    uint64_t maxNumber = 0;
+    size_t numbered = 0;
+    for (size_t i = 0; i < m_names.size(); i++) {
+        uint64_t number;
+        if (decodeHotkeyNumber(name(i), number)) {
+            maxNumber = std::max(maxNumber, number);
+            numbered++;
+        }
+        hasLazyHotkeys |= m_actions[i].type == ShortcutAction::Type::LazyHotkey;
+    }
+
+    m_resolvedHotkeys.reset();
+    if (hasLazyHotkeys) {
+        m_resolvedHotkeys = std::make_unique<std::atomic<obs_hotkey_id>[]>(m_names.size());
+        for (size_t i = 0; i < m_names.size(); i++) {
+            m_resolvedHotkeys[i].store(OBS_INVALID_HOTKEY_ID, std::memory_order_relaxed);
+        }
+    }
+
+    // hotkey ids are allocated sequentially by libobs, so they usually stay dense.
+    // If they don't, the perfect hash takes care of them as well.
+    const uint64_t denseLimit = std::max<uint64_t>(1024, m_names.size() * 8);
+    if (numbered > 0 && maxNumber < denseLimit) {
+        m_numberSlots.assign(maxNumber + 1, -1);
+    }
+
+    std::vector<int32_t> hashed;
+    for (size_t i = 0; i < m_names.size(); i++) {
+        uint64_t number;
+        if (!m_numberSlots.empty() && decodeHotkeyNumber(name(i), number)) {
+            m_numberSlots[number] = static_cast<int32_t>(i);
+        } else {
+            hashed.push_back(static_cast<int32_t>(i));
+        }
+    }
+
+    size_t slotCount = hashed.size() + hashed.size() / 4 + 1;
+    while (!buildPerfectHash(hashed, slotCount)) {
+        slotCount *= 2;
+    }
+
+    // a linear search per target, there are only ever a few gestures
+    const auto resolveTarget = [this](const StoredGestureTarget& gestureTarget) -> int32_t {
+        if (gestureTarget.target.length == 0 || gestureTarget.category == ShortcutCategory::Gesture) {
+            return -1;
+        }
+
+        const QStringView wanted = view(gestureTarget.target);
+        for (size_t i = 0; i < m_names.size(); i++) {
+            if (m_categories[i] == gestureTarget.category && view(m_targets[i]) == wanted) {
+                return static_cast<int32_t>(i);
+            }
+        }
+        return -1;
+    };
+
+    for (size_t i = 0; i < m_gestures.size(); i++) {
+        m_gestures[i].tap = resolveTarget(m_gestureTargets[i * 3]);
+        m_gestures[i].hold = resolveTarget(m_gestureTargets[i * 3 + 1]);
+        m_gestures[i].doubleTap = resolveTarget(m_gestureTargets[i * 3 + 2]);
+    }
+}
+
+qsizetype ShortcutRegistry::find(QStringView name) const
+{
+    int32_t index = -1;
+
+    uint64_t number;
+    if (!m_numberSlots.empty() && decodeHotkeyNumber(name, number)) {
+        if (number >= m_numberSlots.size()) {
+            return -1;
+        }
+        index = m_numberSlots[number];
+    } else if (!m_hashSlots.empty()) {
+        const size_t bucket = qHash(name, 0) % m_bucketSeeds.size();
+        index = m_hashSlots[qHash(name, m_bucketSeeds[bucket]) % m_hashSlots.size()];
+    }
+
+    if (index < 0) {
+        return -1;
+    }
+
+    // the tables only tell us where the name would be, unknown names still land somewhere
+    return this->name(index) == name ? index : -1;
+}
+
+bool ShortcutRegistry::isHoldHotkey(qsizetype index) const
+{
+    if (m_categories[index] != ShortcutCategory::Hotkey) {
+        return false;
+    }
+
+    const QStringView identity = target(index);
+    return identity.endsWith(u"|libobs.push-to-talk") || identity.endsWith(u"|libobs.push-to-mute");
+}
+
+void ShortcutRegistry::resolveHotkey(qsizetype index, obs_hotkey_id id)
+{
+    if (m_actions[index].type == ShortcutAction::Type::LazyHotkey) {
+        m_resolvedHotkeys[index].store(id, std::memory_order_relaxed);
+    }
+}
+
+void ShortcutRegistry::trigger(qsizetype index, bool pressed) const
+{
+    const ShortcutAction& action = m_actions[index];
+
+    switch (action.type) {
+    case ShortcutAction::Type::Hotkey:
+        obs_hotkey_trigger_routed_callback(action.hotkey, pressed);
+        break;
+
+    case ShortcutAction::Type::LazyHotkey: {
+        const obs_hotkey_id id = m_resolvedHotkeys[index].load(std::memory_order_relaxed);
+        if (id != OBS_INVALID_HOTKEY_ID) {
+            obs_hotkey_trigger_routed_callback(id, pressed);
+        }
+        break;
+    }
+
+    case ShortcutAction::Type::Toggle:
+        // only want this to trigger when we press the bind, not when we release it
+        if (pressed) {
+            action.toggle();
+        }
+        break;
+
+    case ShortcutAction::Type::Scene: {
+        if (!pressed) {
+            break;
+        }
+
+        OBSSourceAutoRelease scene = obs_weak_source_get_source(action.scene);
+        if (scene) {
+            obs_frontend_set_current_scene(scene);
+        }
+        break;
+    }
+
+    case ShortcutAction::Type::LazyScene: {
+        if (!pressed) {
+            break;
+        }
+
+        OBSSourceAutoRelease scene = obs_get_source_by_uuid(target(index).toUtf8().constData());
+        if (scene && obs_source_is_scene(scene)) {
+            obs_frontend_set_current_scene(scene);
+        }
+        break;
+    }
+
+    case ShortcutAction::Type::Macro:
+        if (pressed) {
+            runMacro(index, action.macro);
+        }
+        break;
+
+    case ShortcutAction::Type::Gesture:
+        break;
+    }
+}
+
+void ShortcutRegistry::runMacro(qsizetype index, ShortcutAction::StepRange steps) const
+{
+    // nothing could be resolved, or it came from the warm start cache and isn't built yet
+    if (steps.count == 0) {
+        return;
+    }
+
+    // timed first and logged afterwards, so logging doesn't spread the steps apart
+    std::vector<uint64_t> durations(steps.count);
+    const uint64_t start = os_gettime_ns();
+    uint64_t stepStart = start;
+
+    for (uint32_t i = 0; i < steps.count; i++) {
+        const MacroStep& step = m_macroSteps[steps.first + i];
+
+        switch (step.type) {
+        case MacroStep::Type::Hotkey:
+            obs_hotkey_trigger_routed_callback(step.hotkey, true);
+            obs_hotkey_trigger_routed_callback(step.hotkey, false);
+            break;
+
+        case MacroStep::Type::Scene: {
+            OBSSourceAutoRelease scene = obs_weak_source_get_source(step.scene);
+            if (scene) {
+                obs_frontend_set_current_scene(scene);
+            }
+            break;
+        }
+
+        case MacroStep::Type::Frontend:
+            step.run();
+            break;
+        }
+
+        const uint64_t now = os_gettime_ns();
+        durations[i] = now - stepStart;
+        stepStart = now;
+    }
+
+    blog(LOG_INFO, "[ShortcutsPortal] Macro '%s' ran %u steps in %.3f ms", name(index).toUtf8().constData(), steps.count, (stepStart - start) / 1e6);
+    for (uint32_t i = 0; i < steps.count; i++) {
+        blog(LOG_INFO, "[ShortcutsPortal]   %u. %s: %.3f ms", i + 1, view(m_macroLabels[steps.first + i]).toUtf8().constData(), durations[i] / 1e6);
+    }
+}
+
+size_t ShortcutRegistry::memoryUsage() const
+{
+    size_t bytes = m_text.capacity() * sizeof(char16_t);
+    bytes += m_names.capacity() * sizeof(TextRef);
+    bytes += m_descriptions.capacity() * sizeof(uint32_t);
+    bytes += m_targets.capacity() * sizeof(TextRef);
+    bytes += m_categories.capacity() * sizeof(ShortcutCategory);
+    bytes += m_actions.capacity() * sizeof(ShortcutAction);
+    bytes += m_descriptionPool.capacity() * sizeof(TextRef);
+    bytes += m_macroSteps.capacity() * sizeof(MacroStep);
+    bytes += m_macroLabels.capacity() * sizeof(TextRef);
+    bytes += m_gestures.capacity() * sizeof(ShortcutGesture);
+    bytes += m_gestureTargets.capacity() * sizeof(StoredGestureTarget);
+
+    if (m_resolvedHotkeys) {
+        bytes += m_names.size() * sizeof(std::atomic<obs_hotkey_id>);
+    }
+
+    bytes += m_numberSlots.capacity() * sizeof(int32_t);
+    bytes += m_bucketSeeds.capacity() * sizeof(size_t);
+    bytes += m_hashSlots.capacity() * sizeof(int32_t);
+    return bytes;
+}
+
+ShortcutRegistry::TextRef ShortcutRegistry::store(QStringView text)
+{
+    TextRef ref;
+    ref.offset = static_cast<uint32_t>(m_text.size());
+    ref.length = static_cast<uint32_t>(text.size());
+    m_text.insert(m_text.end(), text.utf16(), text.utf16() + text.size());
+    return ref;
+}
+
+void ShortcutRegistry::release(ShortcutAction& action)
+{
+    if (action.type == ShortcutAction::Type::Scene) {
+        obs_weak_source_release(action.scene);
+        action.scene = nullptr;
+    }
+}
+
+bool ShortcutRegistry::decodeHotkeyNumber(QStringView name, uint64_t& number)
+{
+    static constexpr QStringView prefix = u"hk_";
+
+    // at most 19 digits so the number can't overflow
+    const qsizetype digits = name.size() - prefix.size();
+    if (digits <= 0 || digits > 19 || !name.startsWith(prefix)) {
+        return false;
+    }
+
+    // leading zeros would let two different names decode to the same slot
+    if (digits > 1 && name[prefix.size()] == u'0') {
+        return false;
+    }
+
+    number = 0;
+    for (qsizetype i = prefix.size(); i < name.size(); i++) {
+        const char16_t c = name[i].unicode();
+        if (c < u'0' || c > u'9') {
+            return false;
+        }
+        number = number * 10 + (c - u'0');
+    }
+
+    return true;
+}
+
+bool ShortcutRegistry::buildPerfectHash(const std::vector<int32_t>& entries, size_t slotCount)
+{
+    m_bucketSeeds.clear();
+    m_hashSlots.clear();
+
+    if (entries.empty()) {
+        return true;
+    }
+
+    const size_t bucketCount = std::max<size_t>(1, entries.size() / 4);
+    std::vector<std::vector<int32_t>> buckets(bucketCount);
+    for (int32_t entry : entries) {
+        buckets[qHash(name(entry), 0) % bucketCount].push_back(entry);
+    }
+
+    // place the biggest buckets first while the table is still mostly empty
+    std::vector<size_t> order(bucketCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&buckets](size_t a, size_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    m_bucketSeeds.assign(bucketCount, 0);
+    m_hashSlots.assign(slotCount, -1);
+
+    std::vector<size_t> candidate;
+    for (size_t bucketIndex : order) {
+        const auto& bucket = buckets[bucketIndex];
+        if (bucket.empty()) {
+            break;
+        }
+
+        bool placed = false;
+        for (size_t seed = 1; seed < maxSeedAttempts && !placed; seed++) {
+            candidate.clear();
+            placed = true;
+
+            for (int32_t entry : bucket) {
+                const size_t slot = qHash(name(entry), seed) % slotCount;
+                if (m_hashSlots[slot] != -1 || std::find(candidate.begin(), candidate.end(), slot) != candidate.end()) {
+                    placed = false;
+                    break;
+                }
+                candidate.push_back(slot);
+            }
+
+            if (placed) {
+                m_bucketSeeds[bucketIndex] = seed;
+                for (size_t i = 0; i < bucket.size(); i++) {
+                    m_hashSlots[candidate[i]] = bucket[i];
+                }
+            }
+        }
+
+        if (!placed) {
+            return false;
+        }
+    }
+
+    return true;
+}
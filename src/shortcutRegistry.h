@@ -0,0 +1,360 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <obs.h>
+
+#include <QStringView>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class ShortcutCategory : uint8_t {
+    // routed libobs hotkey. Those of sources, outputs, encoders and services can be triggered
+    // from any thread, the frontend's own (OBSBasic.*) call into the UI, see ShortcutAction::uiThread
+    Hotkey,
+    // built-in frontend toggle, must run on the UI thread
+    Toggle,
+    // scene switch, must run on the UI thread
+    Scene,
+    // user defined batch of actions, must run on the UI thread
+    Macro,
+    // tells tap, hold and double tap apart and runs another shortcut for each, see ShortcutDispatcher
+    Gesture,
+};
+
+// Shortcuts a Gesture shortcut runs, indices into the same registry or -1 if unused
+struct ShortcutGesture
+{
+    int32_t tap = -1;
+    int32_t hold = -1;
+    int32_t doubleTap = -1;
+
+    // held at least this long it's a hold, otherwise a tap
+    uint32_t holdMs = 0;
+    // a second press within this long after a tap makes it a double tap, only used with doubleTap
+    uint32_t doubleTapMs = 0;
+};
+
+// The shortcut a gesture runs, found by what it acts on
+struct GestureTarget
+{
+    ShortcutCategory category = ShortcutCategory::Hotkey;
+    // see ShortcutRegistry::target(), empty for none
+    QStringView target;
+};
+
+// One step of a macro, resolved when the registry is built
+struct MacroStep
+{
+    enum class Type : uint8_t {
+        // routed libobs hotkey, pressed and released
+        Hotkey,
+        // scene switch through a weak reference owned by the registry
+        Scene,
+        // frontend call such as starting the stream
+        Frontend,
+    };
+
+    Type type = Type::Frontend;
+
+    union {
+        void (*run)() = nullptr;
+        obs_hotkey_id hotkey;
+        obs_weak_source_t* scene;
+    };
+
+    static MacroStep triggerHotkey(obs_hotkey_id id)
+    {
+        MacroStep step;
+        step.type = Type::Hotkey;
+        step.hotkey = id;
+        return step;
+    }
+
+    // Takes a new weak reference, which the registry releases once the step is added
+    static MacroStep switchScene(obs_source_t* scene)
+    {
+        MacroStep step;
+        step.type = Type::Scene;
+        step.scene = obs_source_get_weak_source(scene);
+        return step;
+    }
+
+    static MacroStep runFrontend(void (*run)())
+    {
+        MacroStep step;
+        step.type = Type::Frontend;
+        step.run = run;
+        return step;
+    }
+};
+
+// What a shortcut does when triggered. Plain data instead of a std::function so building
+// the registry doesn't allocate per shortcut; the lazy kinds keep their key in the target.
+struct ShortcutAction
+{
+    enum class Type : uint8_t {
+        // routed libobs hotkey
+        Hotkey,
+        // libobs hotkey with the identity in the target, its id is filled in by resolveHotkey()
+        // once libobs registered it and it does nothing until then
+        LazyHotkey,
+        // frontend toggle, only acts on the press
+        Toggle,
+        // scene switch through a weak reference owned by the registry, only acts on the press
+        Scene,
+        // switch to the scene whose UUID is the target, only acts on the press
+        LazyScene,
+        // steps stored in the registry, see ShortcutRegistry::takeMacro(), only acts on the press
+        Macro,
+        // interpreted by the dispatcher, triggering it does nothing
+        Gesture,
+    };
+
+    // position of a macro's steps in the registry
+    struct StepRange
+    {
+        uint32_t first;
+        uint32_t count;
+    };
+
+    Type type = Type::Hotkey;
+
+    // for the hotkey kinds: registered by the frontend, its callback touches widgets
+    bool uiThread = false;
+
+    union {
+        obs_hotkey_id hotkey = OBS_INVALID_HOTKEY_ID;
+        void (*toggle)();
+        obs_weak_source_t* scene;
+        StepRange macro;
+        // see ShortcutRegistry::gesture()
+        uint32_t gesture;
+    };
+
+    static ShortcutAction triggerHotkey(obs_hotkey_id id, bool uiThread)
+    {
+        ShortcutAction action;
+        action.type = Type::Hotkey;
+        action.uiThread = uiThread;
+        action.hotkey = id;
+        return action;
+    }
+
+    static ShortcutAction lazyHotkey(bool uiThread)
+    {
+        ShortcutAction action;
+        action.type = Type::LazyHotkey;
+        action.uiThread = uiThread;
+        return action;
+    }
+
+    static ShortcutAction runToggle(void (*toggle)())
+    {
+        ShortcutAction action;
+        action.type = Type::Toggle;
+        action.toggle = toggle;
+        return action;
+    }
+
+    // Takes a new weak reference, which the registry releases once the action is inserted
+    static ShortcutAction switchScene(obs_source_t* scene)
+    {
+        ShortcutAction action;
+        action.type = Type::Scene;
+        action.scene = obs_source_get_weak_source(scene);
+        return action;
+    }
+
+    static ShortcutAction lazyScene()
+    {
+        ShortcutAction action;
+        action.type = Type::LazyScene;
+        return action;
+    }
+};
+
+// Lookup table used to dispatch portal signals.
+// Shortcuts are stored as parallel arrays, all strings live in one buffer and identical
+// descriptions are stored once. "hk_<n>" names are resolved by indexing a table with n,
+// everything else (scenes, toggles) goes through a perfect hash built in finalize().
+class ShortcutRegistry
+{
+public:
+    ShortcutRegistry() = default;
+    ~ShortcutRegistry();
+
+    ShortcutRegistry(const ShortcutRegistry&) = delete;
+    ShortcutRegistry& operator=(const ShortcutRegistry&) = delete;
+
+    // Sizes the buffers after a previous build, which usually has about the same contents
+    void reserve(const ShortcutRegistry& previous);
+
+    void clear();
+
+    // Replaces any existing shortcut with the same name
+    void insert(QStringView name, QStringView description, ShortcutCategory category, QStringView target, ShortcutAction action);
+
+    // Appends a step to the macro being built, label is only used for logging
+    void addMacroStep(MacroStep step, QStringView label);
+
+    // Action running the steps added since the previous call, in order and in one go
+    ShortcutAction takeMacro();
+
+    // Action of a gesture running these shortcuts. They are looked up by finalize(),
+    // gestures can't run other gestures.
+    ShortcutAction addGesture(GestureTarget tap, GestureTarget hold, GestureTarget doubleTap, uint32_t holdMs, uint32_t doubleTapMs);
+
+    // Builds the lookup tables, must be called after the last insert()
+    void finalize();
+
+    // Index of the shortcut or -1, stable until the registry is rebuilt
+    qsizetype find(QStringView name) const;
+
+    QStringView name(qsizetype index) const
+    {
+        return view(m_names[index]);
+    }
+
+    QStringView description(qsizetype index) const
+    {
+        return view(m_descriptionPool[m_descriptions[index]]);
+    }
+
+    // what the shortcut acts on: the hotkey identity, the scene UUID, the toggle or macro id
+    QStringView target(qsizetype index) const
+    {
+        return view(m_targets[index]);
+    }
+
+    ShortcutCategory category(qsizetype index) const
+    {
+        return m_categories[index];
+    }
+
+    // Sets the hotkey a LazyHotkey shortcut triggers. Called from the UI thread while the
+    // registry may be in use, trigger() never looks hotkeys up itself.
+    void resolveHotkey(qsizetype index, obs_hotkey_id id);
+
+    // push-to-talk or push-to-mute: only whether the key is down matters, not each press
+    bool isHoldHotkey(qsizetype index) const;
+
+    // Whether trigger() has to be called on the UI thread: everything but the hotkeys
+    // of sources, outputs, encoders and services
+    bool needsUiThread(qsizetype index) const
+    {
+        return m_categories[index] != ShortcutCategory::Hotkey || m_actions[index].uiThread;
+    }
+
+    // Shortcuts that needsUiThread() must only be triggered on the UI thread
+    void trigger(qsizetype index, bool pressed) const;
+
+    // Gestures are numbered from 0 in the order they were added
+    qsizetype gestureCount() const
+    {
+        return static_cast<qsizetype>(m_gestures.size());
+    }
+
+    // the gesture of a Gesture shortcut, -1 for any other shortcut
+    int32_t gestureSlot(qsizetype index) const
+    {
+        const ShortcutAction& action = m_actions[index];
+        return action.type == ShortcutAction::Type::Gesture ? static_cast<int32_t>(action.gesture) : -1;
+    }
+
+    const ShortcutGesture& gesture(int32_t slot) const
+    {
+        return m_gestures[slot];
+    }
+
+    qsizetype size() const
+    {
+        return static_cast<qsizetype>(m_names.size());
+    }
+
+    // Approximate heap footprint, only used for logging
+    size_t memoryUsage() const;
+
+private:
+    // position of a string in m_text
+    struct TextRef
+    {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    TextRef store(QStringView text);
+
+    QStringView view(TextRef ref) const
+    {
+        return QStringView(m_text.data() + ref.offset, ref.length);
+    }
+
+    static void release(ShortcutAction& action);
+
+    void runMacro(qsizetype index, ShortcutAction::StepRange steps) const;
+    static bool decodeHotkeyNumber(QStringView name, uint64_t& number);
+
+    bool buildPerfectHash(const std::vector<int32_t>& entries, size_t slotCount);
+
+    // every string of the registry, freed in one go with it
+    std::vector<char16_t> m_text;
+
+    // one element per shortcut
+    std::vector<TextRef> m_names;
+    std::vector<uint32_t> m_descriptions;
+    std::vector<TextRef> m_targets;
+    std::vector<ShortcutCategory> m_categories;
+    std::vector<ShortcutAction> m_actions;
+
+    // steps of every macro and their labels, ShortcutAction::macro points into them
+    std::vector<MacroStep> m_macroSteps;
+    std::vector<TextRef> m_macroLabels;
+    uint32_t m_macroStart = 0;
+
+    // what a gesture target is looked up by
+    struct StoredGestureTarget
+    {
+        ShortcutCategory category;
+        TextRef target;
+    };
+
+    // every gesture, with what its shortcuts are resolved from (tap, hold, double tap)
+    std::vector<ShortcutGesture> m_gestures;
+    std::vector<StoredGestureTarget> m_gestureTargets;
+
+    // unique descriptions, m_descriptions indexes into it
+    std::vector<TextRef> m_descriptionPool;
+
+    // open addressing tables only used while inserting, released by finalize()
+    std::vector<int32_t> m_nameIndex;
+    std::vector<int32_t> m_descriptionIndex;
+
+    // ids found for LazyHotkey actions, by shortcut index
+    std::unique_ptr<std::atomic<obs_hotkey_id>[]> m_resolvedHotkeys;
+
+    // shortcut index by decoded "hk_<n>" number, -1 for holes
+    std::vector<int32_t> m_numberSlots;
+
+    // two level perfect hash: the first hash picks a bucket seed, the second one the slot
+    std::vector<size_t> m_bucketSeeds;
+    std::vector<int32_t> m_hashSlots;
+};
@@ -17,12 +17,19 @@
 */
 
 #include "shortcutsPortal.h"
+#include "warmStartCache.h"
 
 #include <obs-frontend-api.h>
 #include <obs-hotkey.h>
 #include <obs.h>
+#include <obs.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
 
 #include <QCryptographicHash>
+#include <QDBusPendingCallWatcher>
 #include <QMessageBox>
 #include <QSet>
 
@@ -39,52 +46,408 @@ using namespace Qt::Literals::StringLiterals;
 static const QString freedesktopDest = u"org.freedesktop.portal.Desktop"_s;
 static const QString freedesktopPath = u"/org/freedesktop/portal/desktop"_s;
 static const QString globalShortcutsInterface = u"org.freedesktop.portal.GlobalShortcuts"_s;
+static const QString privateBusName = u"obs_wayland_hotkeys_dispatch"_s;
+
+// Frontend events come in bursts (collection switch, scripts adding scenes...),
+// wait for them to settle but never delay an update for longer than the cap
+static constexpr qint64 updateQuietMs = 150;
+static constexpr qint64 updateMaxDelayMs = 1000;
+
+static constexpr int statsLogIntervalMs = 5 * 60 * 1000;
+
+// A portal that went away is usually restarted by systemd right away, if it isn't the
+// CreateSession call starts it through D-Bus activation. A closed session is recreated
+// after a short delay so a portal on its way out doesn't get the request.
+static constexpr int portalRestartWaitMs = 1000;
+static constexpr int sessionClosedWaitMs = 250;
+
+// a session that couldn't be created is tried again after 1 s, doubling up to a minute
+static constexpr int createRetryMinMs = 1000;
+static constexpr int createRetryMaxMs = 60 * 1000;
+
+// KDE and Gnome don't allow binding multiple key combinations to the same action like obs does...
+// so add custom "toggle" shortcuts for actions that can be started / stopped
+struct ToggleShortcut
+{
+    const char* id;
+    const char* description;
+    void (*toggle)();
+};
+
+static const ToggleShortcut toggleShortcuts[] = {
+    {"_toggle_recording", "Toggle Recording", []() {
+        if (obs_frontend_recording_active()) {
+            obs_frontend_recording_stop();
+        } else {
+            obs_frontend_recording_start();
+        }
+    }},
+    {"_toggle_streaming", "Toggle Streaming", []() {
+        if (obs_frontend_streaming_active()) {
+            obs_frontend_streaming_stop();
+        } else {
+            obs_frontend_streaming_start();
+        }
+    }},
+    {"_toggle_replay_buffer", "Toggle Replay Buffer", []() {
+        if (obs_frontend_replay_buffer_active()) {
+            obs_frontend_replay_buffer_stop();
+        } else {
+            obs_frontend_replay_buffer_start();
+        }
+    }},
+    {"_toggle_virtualcam", "Toggle Virtual Camera", []() {
+        if (obs_frontend_virtualcam_active()) {
+            obs_frontend_stop_virtualcam();
+        } else {
+            obs_frontend_start_virtualcam();
+        }
+    }},
+
+    // https://github.com/obsproject/obs-studio/pull/12580
+    /* Update release version number and uncomment when related request is merged.
+       Needs a QVersionNumber::fromString(obs_get_version_string()) >= QVersionNumber(32, 1, 0) check in createShortcuts().
+
+    {"_toggle_preview", "Toggle Preview", []() {
+        if (obs_frontend_preview_enabled()) {
+            obs_frontend_set_preview_enabled(false);
+        } else {
+            obs_frontend_set_preview_enabled(true);
+        }
+    }},
+    */
+
+    {"_toggle_studio_mode", "Toggle Studio Mode", []() {
+        if (obs_frontend_preview_program_mode_active()) {
+            obs_frontend_set_preview_program_mode(false);
+        } else {
+            obs_frontend_set_preview_program_mode(true);
+        }
+    }},
+};
+
+// Frontend calls macro steps can use next to the toggles above.
+// Start and stop do nothing if the output is already in that state.
+struct MacroAction
+{
+    const char* id;
+    void (*run)();
+};
+
+static const MacroAction macroActions[] = {
+    {"start_streaming", []() {
+        if (!obs_frontend_streaming_active()) {
+            obs_frontend_streaming_start();
+        }
+    }},
+    {"stop_streaming", []() {
+        if (obs_frontend_streaming_active()) {
+            obs_frontend_streaming_stop();
+        }
+    }},
+    {"start_recording", []() {
+        if (!obs_frontend_recording_active()) {
+            obs_frontend_recording_start();
+        }
+    }},
+    {"stop_recording", []() {
+        if (obs_frontend_recording_active()) {
+            obs_frontend_recording_stop();
+        }
+    }},
+    {"pause_recording", []() {
+        obs_frontend_recording_pause(true);
+    }},
+    {"unpause_recording", []() {
+        obs_frontend_recording_pause(false);
+    }},
+    {"start_replay_buffer", []() {
+        if (!obs_frontend_replay_buffer_active()) {
+            obs_frontend_replay_buffer_start();
+        }
+    }},
+    {"stop_replay_buffer", []() {
+        if (obs_frontend_replay_buffer_active()) {
+            obs_frontend_replay_buffer_stop();
+        }
+    }},
+    {"save_replay_buffer", []() {
+        obs_frontend_replay_buffer_save();
+    }},
+    {"start_virtualcam", []() {
+        if (!obs_frontend_virtualcam_active()) {
+            obs_frontend_start_virtualcam();
+        }
+    }},
+    {"stop_virtualcam", []() {
+        if (obs_frontend_virtualcam_active()) {
+            obs_frontend_stop_virtualcam();
+        }
+    }},
+};
 
 ShortcutsPortal::ShortcutsPortal(QObject* parent)
     : QObject(parent)
+    , m_settings(PluginSettings::load())
+    , m_bus(openBus(m_settings))
+    , m_stats(std::make_shared<LatencyStats>())
+    , m_shortcuts(std::make_shared<ShortcutRegistry>())
 {
-    obs_frontend_add_event_callback(obsFrontendEvent, this);
-}
+    if (m_bus.name() == privateBusName) {
+        m_dispatchThread = new QThread();
+        m_dispatchThread->setObjectName(u"Wayland Hotkeys dispatch"_s);
 
-void ShortcutsPortal::createSession()
-{
-    QDBusMessage createSessionCall = QDBusMessage::createMethodCall(
+        m_dispatcher = new ShortcutDispatcher(m_stats, m_settings.frameAlignedDispatch);
+        m_dispatcher->moveToThread(m_dispatchThread);
+        m_dispatchThread->start();
+
+        blog(LOG_INFO, "[ShortcutsPortal] Dispatching shortcuts on a dedicated thread");
+    } else {
+        m_dispatcher = new ShortcutDispatcher(m_stats, m_settings.frameAlignedDispatch, this);
+    }
+
+    if (m_settings.triggerSocket) {
+        const QString socketPath = TriggerSocket::defaultPath();
+        if (socketPath.isEmpty()) {
+            blog(LOG_WARNING, "[ShortcutsPortal] XDG_RUNTIME_DIR is not set, not starting the trigger socket");
+        } else {
+            m_triggerSocket = std::make_unique<TriggerSocket>(m_dispatcher);
+            if (!m_triggerSocket->start(socketPath)) {
+                m_triggerSocket.reset();
+            }
+        }
+    }
+
+    m_updateTimer.setSingleShot(true);
+    connect(&m_updateTimer, &QTimer::timeout, this, &ShortcutsPortal::flushUpdate);
+
+    m_recoveryTimer.setSingleShot(true);
+    connect(&m_recoveryTimer, &QTimer::timeout, this, &ShortcutsPortal::recoverSessions);
+
+    m_portalWatcher.setConnection(m_bus);
+    m_portalWatcher.setWatchMode(QDBusServiceWatcher::WatchForOwnerChange);
+    m_portalWatcher.addWatchedService(freedesktopDest);
+    connect(&m_portalWatcher, &QDBusServiceWatcher::serviceOwnerChanged, this, &ShortcutsPortal::onPortalOwnerChanged);
+
+    connect(&m_statsTimer, &QTimer::timeout, this, &ShortcutsPortal::logStats);
+    m_statsTimer.start(statsLogIntervalMs);
+
+    // D-Bus argN match rules only apply to string arguments and the session handle is an
+    // object path, so foreign sessions are filtered by the dispatcher instead.
+    // The portal only sends these signals to the connection owning the session anyway.
+    m_bus.connect(
         freedesktopDest,
         freedesktopPath,
         globalShortcutsInterface,
-        u"CreateSession"_s
+        u"Activated"_s,
+        m_dispatcher,
+        SLOT(onActivatedSignal(
+            QDBusObjectPath, QString, qulonglong, QVariantMap
+        ))
+    );
+
+    m_bus.connect(
+        freedesktopDest,
+        freedesktopPath,
+        globalShortcutsInterface,
+        u"Deactivated"_s,
+        m_dispatcher,
+        SLOT(onDeactivatedSignal(
+            QDBusObjectPath, QString, qulonglong, QVariantMap
+        ))
     );
 
-    QList<QVariant> createSessionArgs;
+    obs_frontend_add_event_callback(obsFrontendEvent, this);
 
-    QMap<QString, QVariant> sessionOptions;
-    sessionOptions.insert(u"handle_token"_s, m_handleToken);
-    sessionOptions.insert(u"session_handle_token"_s, m_sessionHandleToken);
-    createSessionArgs.append(sessionOptions);
-    createSessionCall.setArguments(createSessionArgs);
+    signal_handler_t* signals = obs_get_signal_handler();
+    signal_handler_connect(signals, "source_rename", onSourceChanged, this);
+    signal_handler_connect(signals, "source_remove", onSourceChanged, this);
+    signal_handler_connect(signals, "source_rename", onSourceRenamed, this);
+    signal_handler_connect(signals, "hotkey_register", onHotkeyRegister, this);
+    signal_handler_connect(signals, "hotkey_unregister", onHotkeyUnregister, this);
+}
 
-    QDBusMessage call = QDBusConnection::sessionBus().call(createSessionCall);
-    if (call.type() != QDBusMessage::ReplyMessage) {
-        auto errMsg = QMessageBox(m_parentWindow);
-        errMsg.critical(m_parentWindow, u"Failed to create global shortcuts session"_s, call.errorMessage());
+QDBusConnection ShortcutsPortal::openBus(const PluginSettings& settings)
+{
+    if (!settings.dedicatedDispatchThread) {
+        return QDBusConnection::sessionBus();
+    }
+
+    // The portal only sends Activated/Deactivated to the connection that created the session,
+    // so all session traffic has to go through the private connection as well
+    QDBusConnection bus = QDBusConnection::connectToBus(QDBusConnection::SessionBus, privateBusName);
+    if (!bus.isConnected()) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Failed to open private bus connection: %s", bus.lastError().message().toUtf8().constData());
+        QDBusConnection::disconnectFromBus(privateBusName);
+        return QDBusConnection::sessionBus();
     }
 
-    this->m_responseHandle = call.arguments().first().value<QDBusObjectPath>();
+    return bus;
+}
 
+void ShortcutsPortal::createSession()
+{
     qDBusRegisterMetaType<std::pair<QString, QVariantMap>>();
     qDBusRegisterMetaType<QList<QPair<QString, QVariantMap>>>();
+    qDBusRegisterMetaType<ShortcutBindList>();
 
-    QDBusConnection::sessionBus().connect(
-        freedesktopDest,
-        m_responseHandle.path(),
-        u"org.freedesktop.portal.Request"_s,
-        u"Response"_s,
-        this,
-        SLOT(onCreateSessionResponse(uint, QVariantMap))
-    );
+    m_sessions.push_back(addSession());
+    m_sessions.back()->create();
+}
+
+PortalSession* ShortcutsPortal::addSession()
+{
+    // the first session keeps the tokens older versions used, tokens are never reused
+    QString token = u"obs_portal_shortcuts"_s;
+    if (m_sessionCount++ > 0) {
+        token += u"_"_s + QString::number(m_sessionCount);
+    }
+
+    auto* session = new PortalSession(m_bus, token, this);
+    if (!m_primarySession) {
+        m_primarySession = session;
+    }
+
+    connect(session, &PortalSession::created, this, [this, session]() {
+        onSessionCreated(session);
+    });
+
+    connect(session, &PortalSession::closed, this, &ShortcutsPortal::onSessionClosed);
+
+    connect(session, &PortalSession::createFailed, this, [this, session]() {
+        onSessionCreateFailed(session);
+    });
+
+    connect(session, &PortalSession::bindFinished, this, [this](uint response) {
+        // make sure the next update tries again
+        if (response > 1) {
+            m_bindRegistry.reset();
+        }
+        bindNext();
+    });
+
+    connect(session, &PortalSession::error, this, [this](const QString& title, const QString& message) {
+        auto errMsg = QMessageBox(m_parentWindow);
+        errMsg.critical(m_parentWindow, title, message);
+    });
+
+    return session;
+}
+
+void ShortcutsPortal::onSessionCreated(PortalSession* session)
+{
+    updateSessionHandles();
+
+    const bool allCreated = std::all_of(m_sessions.begin(), m_sessions.end(), [](const PortalSession* candidate) {
+        return candidate->isCreated();
+    });
+
+    if (allCreated && m_recoveryElapsed.isValid()) {
+        blog(LOG_INFO, "[ShortcutsPortal] Recreated %zu session(s) %lld ms after losing them", m_sessions.size(), static_cast<long long>(m_recoveryElapsed.elapsed()));
+    }
+
+    if (session != m_primarySession) {
+        bindNext();
+        return;
+    }
+
+    if (m_isLoaded) {
+        // picks up whatever changed while the portal was gone
+        updateShortcuts();
+    } else if (!m_bindRegistry) {
+        // Don't leave hotkeys dead until the collection is loaded, FINISHED_LOADING
+        // then rebuilds the live set and only binds again if it differs from the cached one
+        bindFromCache();
+    }
+
+    // after a recovery the sets the sessions had are still waiting to be sent
+    bindNext();
+}
+
+void ShortcutsPortal::onSessionClosed()
+{
+    updateSessionHandles();
+
+    if (!m_recoveryElapsed.isValid()) {
+        m_recoveryElapsed.start();
+    }
+    if (!m_recoveryTimer.isActive()) {
+        m_recoveryTimer.start(sessionClosedWaitMs);
+    }
+}
+
+void ShortcutsPortal::onSessionCreateFailed(PortalSession* session)
+{
+    // later batches don't have to wait for this one
+    bindNext();
+
+    if (m_recoveryTimer.isActive()) {
+        return;
+    }
+
+    const int shift = std::min(session->createFailures() - 1, 6);
+    const int delayMs = std::min(createRetryMinMs << shift, createRetryMaxMs);
+    blog(LOG_INFO, "[ShortcutsPortal] Creating session %s again in %d ms", session->token().toUtf8().constData(), delayMs);
+    m_recoveryTimer.start(delayMs);
 }
 
-int ShortcutsPortal::getVersion()
+void ShortcutsPortal::onPortalOwnerChanged(const QString&, const QString& oldOwner, const QString& newOwner)
+{
+    if (!newOwner.isEmpty() && oldOwner.isEmpty() && !m_recoveryElapsed.isValid()) {
+        // the portal was started for the first time, nothing to recover
+        return;
+    }
+
+    // Sessions belong to the portal process, whatever the old one handed out is gone
+    if (!oldOwner.isEmpty()) {
+        for (PortalSession* session : m_sessions) {
+            session->reset();
+        }
+        updateSessionHandles();
+
+        if (!m_recoveryElapsed.isValid()) {
+            m_recoveryElapsed.start();
+        }
+    }
+
+    if (newOwner.isEmpty()) {
+        blog(LOG_WARNING, "[ShortcutsPortal] xdg-desktop-portal went away, shortcuts stop working until it is back");
+        m_recoveryTimer.start(portalRestartWaitMs);
+        return;
+    }
+
+    blog(LOG_INFO, "[ShortcutsPortal] xdg-desktop-portal is available again after %lld ms", static_cast<long long>(m_recoveryElapsed.elapsed()));
+    m_recoveryTimer.stop();
+    recoverSessions();
+}
+
+void ShortcutsPortal::recoverSessions()
+{
+    for (PortalSession* session : m_sessions) {
+        if (!session->isCreated() && !session->isCreating()) {
+            session->create();
+        }
+    }
+}
+
+void ShortcutsPortal::updateSessionHandles()
+{
+    QList<QDBusObjectPath> handles;
+    for (const PortalSession* session : m_sessions) {
+        if (session->isCreated()) {
+            handles.append(session->handle());
+        }
+    }
+
+    m_dispatcher->setSessionHandles(handles);
+}
+
+bool ShortcutsPortal::hasSession() const
+{
+    return m_primarySession && m_primarySession->isCreated();
+}
+
+void ShortcutsPortal::probeVersion()
 {
     QDBusMessage message = QDBusMessage::createMethodCall(
         freedesktopDest,
@@ -94,198 +457,400 @@ int ShortcutsPortal::getVersion()
     );
 
     message.setArguments({globalShortcutsInterface, u"version"_s});
-    QDBusMessage reply = QDBusConnection::sessionBus().call(message);
-    auto version = reply.arguments().first().value<QDBusVariant>().variant().toUInt();
-    return version;
-};
+
+    QElapsedTimer timer;
+    timer.start();
+
+    auto* watcher = new QDBusPendingCallWatcher(m_bus.asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, timer](QDBusPendingCallWatcher* watcher) {
+        watcher->deleteLater();
+
+        QDBusPendingReply<QDBusVariant> reply = *watcher;
+        if (reply.isError()) {
+            blog(LOG_WARNING, "[ShortcutsPortal] Failed to get portal version: %s", reply.error().message().toUtf8().constData());
+            return;
+        }
+
+        const uint version = reply.value().variant().toUInt();
+        blog(LOG_INFO, "[ShortcutsPortal] GlobalShortcuts portal version %u (probe took %lld ms)", version, static_cast<long long>(timer.elapsed()));
+
+        Q_EMIT versionReceived(version);
+    });
+}
 
 void ShortcutsPortal::createShortcut(
     const QString& name,
     const QString& description,
-    const std::function<void(bool pressed)>& callback
+    ShortcutCategory category,
+    const QString& target,
+    ShortcutAction action
 )
 {
-    PortalShortcut shortcut;
-    shortcut.name = name;
-    shortcut.description = description;
-    shortcut.callbackFunc = callback;
-
-    m_shortcuts[name] = shortcut;
+    m_shortcuts->insert(name, description, category, target, action);
 };
 
-void ShortcutsPortal::createShortcuts()
+QMap<obs_hotkey_id, ShortcutsPortal::HotkeyInfo>::const_iterator ShortcutsPortal::findNamedHotkey(const TargetDefinition& target) const
 {
-    m_shortcuts.clear();
+    // the identity ends with the hotkey name, see captureHotkey()
+    const QString suffix = u'|' + target.name;
+    return std::find_if(m_hotkeys.cbegin(), m_hotkeys.cend(), [&target, &suffix](const HotkeyInfo& info) {
+        return info.registererName == target.owner && info.identity.endsWith(suffix);
+    });
+}
 
-    // Collect valid source pointers to ensure safety
-    QSet<void*> validSources;
-    obs_enum_sources([](void* data, obs_source_t* source) {
-        auto* set = static_cast<QSet<void*>*>(data);
-        set->insert(static_cast<void*>(source));
+void ShortcutsPortal::createMacros()
+{
+    for (const MacroDefinition& macro : m_macros.load()) {
+        for (const TargetDefinition& step : macro.steps) {
+            const QByteArray name = step.name.toUtf8();
+
+            switch (step.kind) {
+            case TargetDefinition::Kind::Scene: {
+                OBSSourceAutoRelease scene = obs_get_source_by_name(name.constData());
+                if (scene && obs_source_is_scene(scene)) {
+                    m_shortcuts->addMacroStep(MacroStep::switchScene(scene), u"scene '"_s + step.name + u'\'');
+                    continue;
+                }
+                break;
+            }
 
-        // Also add filters for this source
-        obs_source_enum_filters(source, [](obs_source_t*, obs_source_t* filter, void* p) {
-            auto* s = static_cast<QSet<void*>*>(p);
-            s->insert(static_cast<void*>(filter));
-        }, set);
+            case TargetDefinition::Kind::Hotkey: {
+                auto it = findNamedHotkey(step);
+                if (it != m_hotkeys.cend()) {
+                    m_shortcuts->addMacroStep(MacroStep::triggerHotkey(it.key()), u"hotkey '"_s + it.value().description + u'\'');
+                    continue;
+                }
+                break;
+            }
 
-        return true;
-    }, &validSources);
+            case TargetDefinition::Kind::Action: {
+                auto action = std::find_if(std::begin(macroActions), std::end(macroActions), [&name](const MacroAction& candidate) {
+                    return name == candidate.id;
+                });
+                if (action != std::end(macroActions)) {
+                    m_shortcuts->addMacroStep(MacroStep::runFrontend(action->run), step.name);
+                    continue;
+                }
 
-    struct EnumContext {
-        ShortcutsPortal* portal;
-        QSet<void*>* validSources;
-        QSet<QString> addedDescriptions;
-    };
+                auto toggle = std::find_if(std::begin(toggleShortcuts), std::end(toggleShortcuts), [&name](const ToggleShortcut& candidate) {
+                    return name == candidate.id;
+                });
+                if (toggle != std::end(toggleShortcuts)) {
+                    m_shortcuts->addMacroStep(MacroStep::runFrontend(toggle->toggle), step.name);
+                    continue;
+                }
+                break;
+            }
 
-    EnumContext ctx;
-    ctx.portal = this;
-    ctx.validSources = &validSources;
+            case TargetDefinition::Kind::Macro:
+                blog(LOG_WARNING, "[ShortcutsPortal] Macro '%s': macros can't run other macros, skipping '%s'", macro.id.toUtf8().constData(), name.constData());
+                continue;
+            }
 
-    obs_enum_hotkeys(
-        [](void* data, obs_hotkey_id id, obs_hotkey_t* binding) {
-            auto* ctx = static_cast<EnumContext*>(data);
+            blog(LOG_WARNING, "[ShortcutsPortal] Macro '%s': could not find '%s', skipping the step", macro.id.toUtf8().constData(), name.constData());
+        }
 
-            const char* nameStr = obs_hotkey_get_name(binding);
-            QString qNameStr = nameStr ? QString::fromUtf8(nameStr) : QString();
+        createShortcut(u"_macro_"_s + macro.id, macro.description, ShortcutCategory::Macro, macro.id, m_shortcuts->takeMacro());
+    }
+}
 
-            // Filter out internal scene switching and scene item visibility toggles
-            if (qNameStr == u"OBSBasic.SelectScene"_s ||
-                qNameStr.contains(u"show_scene_item"_s) ||
-                qNameStr.contains(u"hide_scene_item"_s)) {
-                return true;
-            }
+QString ShortcutsPortal::gestureTarget(const TargetDefinition& definition, ShortcutCategory& category) const
+{
+    switch (definition.kind) {
+    case TargetDefinition::Kind::Scene: {
+        category = ShortcutCategory::Scene;
+        OBSSourceAutoRelease scene = obs_get_source_by_name(definition.name.toUtf8().constData());
+        return scene && obs_source_is_scene(scene) ? QString::fromUtf8(obs_source_get_uuid(scene)) : QString();
+    }
 
-            const char* descStr = obs_hotkey_get_description(binding);
-            QString description = descStr ? QString::fromUtf8(descStr) : QString();
+    case TargetDefinition::Kind::Hotkey: {
+        category = ShortcutCategory::Hotkey;
+        auto it = findNamedHotkey(definition);
+        return it != m_hotkeys.cend() ? it.value().identity : QString();
+    }
 
-            if (description.isEmpty()) {
-                 description = !qNameStr.isEmpty() ? qNameStr : "Unknown Hotkey";
-            }
+    case TargetDefinition::Kind::Action:
+        // the other frontend actions aren't shortcuts of their own, only macros can run them
+        category = ShortcutCategory::Toggle;
+        return definition.name;
 
-            QString namePrefix;
-            obs_hotkey_registerer_type type = obs_hotkey_get_registerer_type(binding);
-            void* registerer = obs_hotkey_get_registerer(binding);
-
-            if (registerer) {
-                const char* name = nullptr;
-                if (type == OBS_HOTKEY_REGISTERER_SOURCE) {
-                    // Only access the source if we verified it exists
-                    if (ctx->validSources && ctx->validSources->contains(registerer)) {
-                        name = obs_source_get_name(static_cast<obs_source_t*>(registerer));
-                    } else {
-                        blog(LOG_WARNING, "[ShortcutsPortal] Skipping invalid source pointer for hotkey ID %lu", (unsigned long)id);
-                    }
-                } else if (type == OBS_HOTKEY_REGISTERER_OUTPUT) {
-                    name = obs_output_get_name(static_cast<obs_output_t*>(registerer));
-                } else if (type == OBS_HOTKEY_REGISTERER_ENCODER) {
-                    name = obs_encoder_get_name(static_cast<obs_encoder_t*>(registerer));
-                } else if (type == OBS_HOTKEY_REGISTERER_SERVICE) {
-                    name = obs_service_get_name(static_cast<obs_service_t*>(registerer));
-                }
+    case TargetDefinition::Kind::Macro:
+        category = ShortcutCategory::Macro;
+        return definition.name;
+    }
 
-                if (name) {
-                    namePrefix = QString::fromUtf8(name);
-                }
-            }
+    return QString();
+}
 
-            if (!namePrefix.isEmpty()) {
-                description = QString("[%1] %2").arg(namePrefix, description);
-            }
+void ShortcutsPortal::createGestures()
+{
+    for (const GestureDefinition& gesture : m_gestures.load()) {
+        ShortcutCategory categories[3] = {};
+        const QString targets[3] = {
+            gestureTarget(gesture.tap, categories[0]),
+            gestureTarget(gesture.hold, categories[1]),
+            gestureTarget(gesture.doubleTap, categories[2]),
+        };
+
+        createShortcut(
+            u"_gesture_"_s + gesture.id,
+            gesture.description,
+            ShortcutCategory::Gesture,
+            gesture.id,
+            m_shortcuts->addGesture(
+                {categories[0], targets[0]},
+                {categories[1], targets[1]},
+                {categories[2], targets[2]},
+                gesture.holdMs,
+                gesture.doubleTapMs
+            )
+        );
+    }
+}
 
-            // Deduplicate: if we already added a shortcut with this exact description, skip it.
-            if (ctx->addedDescriptions.contains(description)) {
-                return true;
+void ShortcutsPortal::checkGestures() const
+{
+    // createGestures() adds one gesture per definition, in order
+    const QList<GestureDefinition>& gestures = m_gestures.gestures();
+    for (qsizetype i = 0; i < gestures.size() && i < m_shortcuts->gestureCount(); i++) {
+        const GestureDefinition& definition = gestures[i];
+        const ShortcutGesture& gesture = m_shortcuts->gesture(static_cast<int32_t>(i));
+
+        const std::pair<const TargetDefinition&, int32_t> targets[] = {
+            {definition.tap, gesture.tap},
+            {definition.hold, gesture.hold},
+            {definition.doubleTap, gesture.doubleTap},
+        };
+        for (const auto& [target, index] : targets) {
+            if (!target.isEmpty() && index < 0) {
+                blog(LOG_WARNING, "[ShortcutsPortal] Gesture '%s': could not find '%s', ignoring it. Actions other than the toggles have to be wrapped in a macro.", definition.id.toUtf8().constData(), target.name.toUtf8().constData());
             }
-            ctx->addedDescriptions.insert(description);
+        }
+    }
+}
 
-            // Use the unique ID as the key to avoid collisions (e.g. scenes share the same name)
-            // Prefix with "hk_" to ensure it doesn't start with a digit, which is invalid for DBus object path elements
-            QString uniqueId = "hk_" + QString::number(id);
+void ShortcutsPortal::seedHotkeys()
+{
+    QElapsedTimer timer;
+    timer.start();
 
-            ctx->portal->createShortcut(uniqueId, description, [id](bool pressed) {
-                obs_hotkey_trigger_routed_callback(id, pressed);
-            });
+    m_hotkeys.clear();
 
+    // Registerers are resolved through the weak references libobs keeps for them,
+    // so there is no need to collect every source and filter up front to validate them
+    obs_enum_hotkeys(
+        [](void* data, obs_hotkey_id id, obs_hotkey_t* binding) {
+            auto* portal = static_cast<ShortcutsPortal*>(data);
+
+            HotkeyInfo info;
+            if (!captureHotkey(binding, info)) {
+                return true;
+            }
+
+            portal->m_hotkeys.insert(id, info);
             return true;
         },
-        &ctx
+        this
     );
 
-    // KDE and Gnome don't allow binding multiple key combinations to the same action like obs does...
-    // so add custom "toggle" shortcuts for actions that can be started / stopped
+    m_hotkeysSeeded = true;
 
-    createShortcut("_toggle_recording", "Toggle Recording", [](bool pressed) {
-        // only want this to trigger when we press the bind, not when we release it
-        if (!pressed)
-            return;
+    blog(LOG_INFO, "[ShortcutsPortal] Collected %lld hotkeys in %.2f ms", static_cast<long long>(m_hotkeys.size()), timer.nsecsElapsed() / 1e6);
+}
 
-        if (obs_frontend_recording_active()) {
-            obs_frontend_recording_stop();
-        } else {
-            obs_frontend_recording_start();
-        }
-    });
+bool ShortcutsPortal::captureHotkey(obs_hotkey_t* hotkey, HotkeyInfo& info)
+{
+    const char* nameStr = obs_hotkey_get_name(hotkey);
+    QString qNameStr = nameStr ? QString::fromUtf8(nameStr) : QString();
+
+    // Filter out internal scene switching and scene item visibility toggles
+    if (qNameStr == u"OBSBasic.SelectScene"_s ||
+        qNameStr.contains(u"show_scene_item"_s) ||
+        qNameStr.contains(u"hide_scene_item"_s)) {
+        return false;
+    }
 
-    createShortcut("_toggle_streaming", "Toggle Streaming", [](bool pressed) {
-        if (!pressed)
-            return;
+    const char* descStr = obs_hotkey_get_description(hotkey);
+    QString description = descStr ? QString::fromUtf8(descStr) : QString();
 
-        if (obs_frontend_streaming_active()) {
-            obs_frontend_streaming_stop();
-        } else {
-            obs_frontend_streaming_start();
-        }
-    });
+    if (description.isEmpty()) {
+         description = !qNameStr.isEmpty() ? qNameStr : "Unknown Hotkey";
+    }
 
-    createShortcut("_toggle_replay_buffer", "Toggle Replay Buffer", [](bool pressed) {
-        if (!pressed)
-            return;
+    info.description = description;
+    info.registerer = obs_hotkey_get_registerer(hotkey);
+
+    // libobs keeps weak references to the registerers, so an upgrade also tells us whether they still exist.
+    // Sources are identified by their UUID, the other registerers don't have one and use their name.
+    obs_hotkey_registerer_type type = obs_hotkey_get_registerer_type(hotkey);
+    const char* registererName = nullptr;
+    const char* registererKey = nullptr;
+    const char* typeName = "frontend";
+
+    if (type == OBS_HOTKEY_REGISTERER_SOURCE) {
+        OBSSourceAutoRelease source = obs_weak_source_get_source(static_cast<obs_weak_source_t*>(info.registerer));
+        registererName = source ? obs_source_get_name(source) : nullptr;
+        registererKey = source ? obs_source_get_uuid(source) : nullptr;
+        typeName = "source";
+    } else if (type == OBS_HOTKEY_REGISTERER_OUTPUT) {
+        OBSOutputAutoRelease output = obs_weak_output_get_output(static_cast<obs_weak_output_t*>(info.registerer));
+        registererName = output ? obs_output_get_name(output) : nullptr;
+        registererKey = registererName;
+        typeName = "output";
+    } else if (type == OBS_HOTKEY_REGISTERER_ENCODER) {
+        OBSEncoderAutoRelease encoder = obs_weak_encoder_get_encoder(static_cast<obs_weak_encoder_t*>(info.registerer));
+        registererName = encoder ? obs_encoder_get_name(encoder) : nullptr;
+        registererKey = registererName;
+        typeName = "encoder";
+    } else if (type == OBS_HOTKEY_REGISTERER_SERVICE) {
+        OBSServiceAutoRelease service = obs_weak_service_get_service(static_cast<obs_weak_service_t*>(info.registerer));
+        registererName = service ? obs_service_get_name(service) : nullptr;
+        registererKey = registererName;
+        typeName = "service";
+    }
 
-        if (obs_frontend_replay_buffer_active()) {
-            obs_frontend_replay_buffer_stop();
-        } else {
-            obs_frontend_replay_buffer_start();
+    info.registererName = registererName ? QString::fromUtf8(registererName) : QString();
+    info.identity = QString::fromUtf8(typeName) + u'|' + QString::fromUtf8(registererKey ? registererKey : "") + u'|' + qNameStr;
+    return true;
+}
+
+void ShortcutsPortal::onHotkeyRegister(void* data, calldata_t* params)
+{
+    auto* portal = static_cast<ShortcutsPortal*>(data);
+    auto* hotkey = static_cast<obs_hotkey_t*>(calldata_ptr(params, "key"));
+    if (!hotkey) {
+        return;
+    }
+
+    // The hotkey is only guaranteed to exist for the duration of the signal,
+    // so capture everything we need before leaving it
+    HotkeyInfo info;
+    if (!captureHotkey(hotkey, info)) {
+        return;
+    }
+
+    const obs_hotkey_id id = obs_hotkey_get_id(hotkey);
+    QMetaObject::invokeMethod(portal, [portal, id, info]() {
+        portal->m_hotkeys.insert(id, info);
+        portal->resolveLazyHotkey(id, info);
+        portal->scheduleHotkeyUpdate();
+    }, Qt::QueuedConnection);
+}
+
+void ShortcutsPortal::onHotkeyUnregister(void* data, calldata_t* params)
+{
+    auto* portal = static_cast<ShortcutsPortal*>(data);
+    auto* hotkey = static_cast<obs_hotkey_t*>(calldata_ptr(params, "key"));
+    if (!hotkey) {
+        return;
+    }
+
+    const obs_hotkey_id id = obs_hotkey_get_id(hotkey);
+    QMetaObject::invokeMethod(portal, [portal, id]() {
+        if (portal->m_hotkeys.remove(id) > 0) {
+            portal->scheduleHotkeyUpdate();
         }
-    });
+    }, Qt::QueuedConnection);
+}
 
-    createShortcut("_toggle_virtualcam", "Toggle Virtual Camera", [](bool pressed) {
-        if (!pressed)
-            return;
+void ShortcutsPortal::onSourceRenamed(void* data, calldata_t* params)
+{
+    auto* portal = static_cast<ShortcutsPortal*>(data);
+    auto* source = static_cast<obs_source_t*>(calldata_ptr(params, "source"));
+    const char* newName = calldata_string(params, "new_name");
+    if (!source || !newName) {
+        return;
+    }
 
-        if (obs_frontend_virtualcam_active()) {
-            obs_frontend_stop_virtualcam();
-        } else {
-            obs_frontend_start_virtualcam();
+    // hotkeys remember their source by its weak reference, only used as a key here
+    OBSWeakSourceAutoRelease weak = obs_source_get_weak_source(source);
+    void* registerer = weak.Get();
+    QString name = QString::fromUtf8(newName);
+
+    QMetaObject::invokeMethod(portal, [portal, registerer, name]() {
+        bool changed = false;
+        for (auto& info : portal->m_hotkeys) {
+            if (info.registerer == registerer) {
+                info.registererName = name;
+                changed = true;
+            }
         }
-    });
 
-    // https://github.com/obsproject/obs-studio/pull/12580
-    /* Update release version number and uncomment when related request is merged.
+        if (changed) {
+            portal->scheduleHotkeyUpdate();
+        }
+    }, Qt::QueuedConnection);
+}
 
-    if (QVersionNumber::fromString(obs_get_version_string()) >= QVersionNumber(32, 1, 0))
-        createShortcut("_toggle_preview", "Toggle Preview", [](bool pressed) {
-            if (!pressed)
-                return;
+// Identities start with the registerer type, see captureHotkey()
+static bool isFrontendHotkey(QStringView identity)
+{
+    return identity.startsWith(u"frontend|");
+}
 
-            if (obs_frontend_preview_enabled()) {
-                obs_frontend_set_preview_enabled(false);
-            } else {
-                obs_frontend_set_preview_enabled(true);
-            }
-        });
-    */
+void ShortcutsPortal::resolveLazyHotkey(obs_hotkey_id id, const HotkeyInfo& info)
+{
+    auto lazy = m_lazyHotkeys.constFind(info.identity);
+    if (lazy != m_lazyHotkeys.cend()) {
+        m_shortcuts->resolveHotkey(lazy.value(), id);
+    }
+}
 
-    createShortcut("_toggle_studio_mode", "Toggle Studio Mode", [](bool pressed) {
-        if (!pressed)
-            return;
+void ShortcutsPortal::scheduleHotkeyUpdate()
+{
+    if (m_isLoaded && hasSession()) {
+        scheduleUpdate();
+    }
+}
 
-        if (obs_frontend_preview_program_mode_active()) {
-            obs_frontend_set_preview_program_mode(false);
-        } else {
-            obs_frontend_set_preview_program_mode(true);
+void ShortcutsPortal::createShortcuts()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // the previous build is the best guess for the size of this one
+    const std::shared_ptr<const ShortcutRegistry> previous = m_shortcuts;
+    m_shortcuts = std::make_shared<ShortcutRegistry>();
+    m_shortcuts->reserve(*previous);
+    m_lazyHotkeys.clear();
+
+    char* collection = obs_frontend_get_current_scene_collection();
+    m_identities.load(QString::fromUtf8(collection ? collection : ""));
+    bfree(collection);
+
+    // Only the first build has to walk libobs, afterwards the hotkey signals keep m_hotkeys current
+    if (!m_hotkeysSeeded) {
+        seedHotkeys();
+    }
+
+    QSet<QString> addedDescriptions;
+
+    // ids are allocated in registration order, same order obs_enum_hotkeys uses
+    for (auto it = m_hotkeys.cbegin(); it != m_hotkeys.cend(); ++it) {
+        const HotkeyInfo& info = it.value();
+
+        QString description = info.description;
+        if (!info.registererName.isEmpty()) {
+            description = QString("[%1] %2").arg(info.registererName, description);
         }
-    });
+
+        // Deduplicate: if we already added a shortcut with this exact description, skip it.
+        if (addedDescriptions.contains(description)) {
+            continue;
+        }
+        addedDescriptions.insert(description);
+
+        // Stable "hk_<n>" id from the identity registry, libobs ids change between runs.
+        // Prefix with "hk_" to ensure it doesn't start with a digit, which is invalid for DBus object path elements
+        const obs_hotkey_id id = it.key();
+        QString uniqueId = m_identities.hotkeyId(info.identity, id);
+
+        createShortcut(uniqueId, description, ShortcutCategory::Hotkey, info.identity, ShortcutAction::triggerHotkey(id, isFrontendHotkey(info.identity)));
+    }
+
+    for (const auto& toggle : toggleShortcuts) {
+        createShortcut(toggle.id, toggle.description, ShortcutCategory::Toggle, toggle.id, ShortcutAction::runToggle(toggle.toggle));
+    }
 
     struct obs_frontend_source_list scenes = {};
     obs_frontend_get_scenes(&scenes);
@@ -298,133 +863,351 @@ void ShortcutsPortal::createShortcuts()
         if (qName.isEmpty())
             continue;
 
-        // Use MD5 hash of the scene name to generate a unique, stable, alphanumeric ID
-        QString id = "scene_" + QCryptographicHash::hash(qName.toUtf8(), QCryptographicHash::Md5).toHex();
+        // Scenes are identified by UUID so renaming one keeps its id. New scenes still get
+        // the MD5 of their name if it's free, which is what older versions used.
+        QString legacyId = "scene_" + QCryptographicHash::hash(qName.toUtf8(), QCryptographicHash::Md5).toHex();
+        const QString uuid = QString::fromUtf8(obs_source_get_uuid(source));
+        QString id = m_identities.sceneId(u"scene|"_s + uuid, legacyId);
 
         QString description = "Switch to scene '" + qName + "'";
 
-        createShortcut(id, description, [qName](bool pressed) {
-            if (!pressed)
-                return;
-
-            obs_source_t* scene = obs_get_source_by_name(qName.toUtf8().constData());
-            if (scene) {
-                obs_frontend_set_current_scene(scene);
-                obs_source_release(scene);
-            }
-        });
+        // Resolve the scene once, a press only has to upgrade the weak reference.
+        // Renames and removals trigger an update through onSourceChanged().
+        createShortcut(id, description, ShortcutCategory::Scene, uuid, ShortcutAction::switchScene(source));
     }
     obs_frontend_source_list_free(&scenes);
+
+    createMacros();
+    createGestures();
+
+    m_shortcuts->finalize();
+    m_dispatcher->setRegistry(m_shortcuts);
+    checkGestures();
+
+    m_identities.save();
+
+    blog(
+        LOG_INFO,
+        "[ShortcutsPortal] Built %lld shortcuts from %lld hotkeys in %.2f ms, registry uses ~%zu KiB (previous build ~%zu KiB)",
+        static_cast<long long>(m_shortcuts->size()),
+        static_cast<long long>(m_hotkeys.size()),
+        timer.nsecsElapsed() / 1e6,
+        m_shortcuts->memoryUsage() / 1024,
+        previous->memoryUsage() / 1024
+    );
 }
 
-void ShortcutsPortal::onCreateSessionResponse(uint, const QVariantMap& results)
+bool ShortcutsPortal::bindFromCache()
 {
-    if (results.contains(u"session_handle"_s)) {
-        QString sessionHandle = results[u"session_handle"_s].toString();
-        this->m_sessionObjPath = QDBusObjectPath(sessionHandle);
-    } else {
-        blog(LOG_WARNING, "[ShortcutsPortal] Session creation response did not contain session_handle");
-    };
+    QElapsedTimer timer;
+    timer.start();
 
-    QDBusConnection::sessionBus().disconnect(
-        freedesktopDest,
-        m_responseHandle.path(),
-        u"org.freedesktop.portal.Request"_s,
-        u"Response"_s,
-        this,
-        SLOT(onCreateSessionResponse(uint, QVariantMap))
-    );
+    char* collection = obs_frontend_get_current_scene_collection();
+    const QString collectionName = QString::fromUtf8(collection ? collection : "");
+    bfree(collection);
 
-    QDBusConnection::sessionBus().connect(
-        freedesktopDest,
-        freedesktopPath,
-        globalShortcutsInterface,
-        u"Activated"_s,
-        this,
-        SLOT(onActivatedSignal(
-            QDBusObjectPath, QString, qulonglong, QVariantMap
-        ))
-    );
+    const QList<CachedShortcut> cached = WarmStartCache::load(collectionName);
+    if (cached.isEmpty()) {
+        return false;
+    }
 
-    QDBusConnection::sessionBus().connect(
-        freedesktopDest,
-        freedesktopPath,
-        globalShortcutsInterface,
-        u"Deactivated"_s,
-        this,
-        SLOT(onDeactivatedSignal(
-            QDBusObjectPath, QString, qulonglong, QVariantMap
-        ))
+    m_identities.load(collectionName);
+    m_shortcuts = std::make_shared<ShortcutRegistry>();
+
+    // most sources don't exist until the collection has loaded, their hotkeys are
+    // filled in by onHotkeyRegister() as they appear
+    for (const auto& entry : cached) {
+        ShortcutAction action = ShortcutAction::lazyHotkey(isFrontendHotkey(entry.target));
+
+        if (entry.category == ShortcutCategory::Toggle) {
+            auto toggle = std::find_if(std::begin(toggleShortcuts), std::end(toggleShortcuts), [&entry](const ToggleShortcut& candidate) {
+                return entry.target == QLatin1String(candidate.id);
+            });
+            if (toggle == std::end(toggleShortcuts)) {
+                continue;
+            }
+            action = ShortcutAction::runToggle(toggle->toggle);
+        } else if (entry.category == ShortcutCategory::Scene) {
+            action = ShortcutAction::lazyScene();
+        } else if (entry.category == ShortcutCategory::Macro) {
+            // does nothing until the collection has loaded and the steps can be resolved
+            action = m_shortcuts->takeMacro();
+        } else if (entry.category == ShortcutCategory::Gesture) {
+            // same for gestures, their targets may not have been cached
+            action = m_shortcuts->addGesture({}, {}, {}, 0, 0);
+        }
+
+        createShortcut(entry.name, entry.description, entry.category, entry.target, action);
+    }
+
+    m_shortcuts->finalize();
+
+    m_lazyHotkeys.clear();
+    for (qsizetype i = 0; i < m_shortcuts->size(); i++) {
+        if (m_shortcuts->category(i) == ShortcutCategory::Hotkey) {
+            m_lazyHotkeys.insert(m_shortcuts->target(i).toString(), i);
+        }
+    }
+
+    // one walk for the hotkeys that are already there, e.g. the frontend's
+    obs_enum_hotkeys(
+        [](void* data, obs_hotkey_id id, obs_hotkey_t* binding) {
+            auto* portal = static_cast<ShortcutsPortal*>(data);
+
+            HotkeyInfo info;
+            if (captureHotkey(binding, info)) {
+                portal->resolveLazyHotkey(id, info);
+            }
+            return true;
+        },
+        this
     );
 
-    if (m_isLoaded) {
-        createShortcuts();
-        bindShortcuts();
+    m_dispatcher->setRegistry(m_shortcuts);
+
+    blog(LOG_INFO, "[ShortcutsPortal] Loaded %lld cached shortcuts in %.2f ms, binding them before OBS finished loading", static_cast<long long>(m_shortcuts->size()), timer.nsecsElapsed() / 1e6);
+
+    bindShortcuts();
+    return true;
+}
+
+void ShortcutsPortal::updateShortcuts()
+{
+    createShortcuts();
+
+    // BindShortcuts replaces the whole set of the session, so the delta only decides
+    // whether the portal has to be involved at all
+    const qsizetype boundCount = m_bindRegistry ? m_bindRegistry->size() : 0;
+    qsizetype added = 0;
+    qsizetype changed = 0;
+    for (qsizetype i = 0; i < m_shortcuts->size(); i++) {
+        const qsizetype bound = m_bindRegistry ? m_bindRegistry->find(m_shortcuts->name(i)) : -1;
+        if (bound < 0) {
+            added++;
+        } else if (m_bindRegistry->description(bound) != m_shortcuts->description(i)) {
+            changed++;
+        }
+    }
+    const qsizetype removed = boundCount - (m_shortcuts->size() - added);
+
+    if (added == 0 && changed == 0 && removed == 0) {
+        blog(LOG_DEBUG, "[ShortcutsPortal] Shortcuts unchanged, skipping bind");
+        return;
     }
+
+    blog(LOG_INFO, "[ShortcutsPortal] Shortcuts changed: %lld added, %lld removed, %lld renamed", static_cast<long long>(added), static_cast<long long>(removed), static_cast<long long>(changed));
+    bindShortcuts();
 }
 
-void ShortcutsPortal::onActivatedSignal(
-    const QDBusObjectPath&,
-    const QString& shortcutName,
-    qulonglong,
-    const QVariantMap&
-)
+void ShortcutsPortal::scheduleUpdate()
 {
-    if (m_shortcuts.contains(shortcutName)) {
-        m_shortcuts[shortcutName].callbackFunc(true);
+    if (m_pendingUpdates++ == 0) {
+        m_pendingUpdateTimer.start();
     }
+
+    const qint64 remaining = updateMaxDelayMs - m_pendingUpdateTimer.elapsed();
+    m_updateTimer.start(std::clamp<qint64>(remaining, 0, updateQuietMs));
 }
 
-void ShortcutsPortal::onDeactivatedSignal(
-    const QDBusObjectPath&,
-    const QString& shortcutName,
-    qulonglong,
-    const QVariantMap&
-)
+void ShortcutsPortal::flushUpdate()
 {
-    if (m_shortcuts.contains(shortcutName)) {
-        m_shortcuts[shortcutName].callbackFunc(false);
+    const int merged = m_pendingUpdates;
+    m_pendingUpdates = 0;
+
+    blog(LOG_INFO, "[ShortcutsPortal] Updating shortcuts for %d merged event(s), %lld ms after the first one", merged, static_cast<long long>(m_pendingUpdateTimer.elapsed()));
+    updateShortcuts();
+}
+
+void ShortcutsPortal::logStats()
+{
+    // stay quiet unless something was pressed since the last summary
+    const uint64_t samples = m_stats->sampleCount();
+    if (samples == m_loggedSamples) {
+        return;
+    }
+    m_loggedSamples = samples;
+
+    blog(LOG_INFO, "[ShortcutsPortal] Activation latency summary:");
+    for (const QString& line : m_stats->summary().split(u'\n', Qt::SkipEmptyParts)) {
+        blog(LOG_INFO, "[ShortcutsPortal]   %s", line.toUtf8().constData());
     }
 }
 
 void ShortcutsPortal::bindShortcuts()
 {
-    QDBusMessage bindShortcuts = QDBusMessage::createMethodCall(
-        freedesktopDest,
-        freedesktopPath,
-        globalShortcutsInterface,
-        u"BindShortcuts"_s
-    );
+    m_bindRegistry = m_shortcuts;
+    m_bindCollection = m_identities.collection();
+    m_bindAllTimer.start();
+
+    const std::vector<SessionPlan> plan = planSessions();
+
+    // Parts keep the session they had, so an unchanged part is left alone
+    std::vector<PortalSession*> assigned(plan.size(), nullptr);
+    std::vector<PortalSession*> unused;
+    for (PortalSession* session : m_sessions) {
+        auto it = std::find_if(plan.begin(), plan.end(), [session](const SessionPlan& part) {
+            return part.key == session->key();
+        });
 
-    QList<std::pair<QString, QVariantMap>> shortcuts;
+        if (it != plan.end()) {
+            assigned[it - plan.begin()] = session;
+        } else {
+            unused.push_back(session);
+        }
+    }
 
-    for (auto shortcut : m_shortcuts) {
-        std::pair<QString, QVariantMap> dbusShortcut;
+    std::vector<PortalSession*> sessions;
+    for (size_t i = 0; i < plan.size(); i++) {
+        PortalSession* session = assigned[i];
+        if (!session && !unused.empty()) {
+            session = unused.front();
+            unused.erase(unused.begin());
+        } else if (!session) {
+            session = addSession();
+            session->create();
+        }
 
-        QVariantMap shortcutOptions;
-        dbusShortcut.first = shortcut.name;
-        shortcutOptions.insert(u"description"_s, shortcut.description);
-        dbusShortcut.second = shortcutOptions;
+        session->setKey(plan[i].key);
+        session->setShortcuts(plan[i].shortcuts);
+        sessions.push_back(session);
+    }
 
-        shortcuts.append(dbusShortcut);
+    // Closing a session also unbinds its shortcuts. The first one stays open for
+    // ConfigureShortcuts and is emptied instead.
+    for (PortalSession* session : unused) {
+        if (session == m_primarySession) {
+            session->setKey(QString());
+            session->setShortcuts(ShortcutBindList());
+            sessions.push_back(session);
+        } else {
+            delete session;
+        }
     }
 
-    QMap<QString, QVariant> bindOptions;
-    bindOptions.insert(u"handle_token"_s, m_handleToken);
+    m_sessions = std::move(sessions);
+    updateSessionHandles();
 
-    QList<QVariant> shortcutArgs;
-    shortcutArgs.append(m_sessionObjPath);
-    shortcutArgs.append(QVariant::fromValue(shortcuts));
+    if (plan.size() > 1) {
+        blog(LOG_INFO, "[ShortcutsPortal] Binding %lld shortcuts in %zu sessions", static_cast<long long>(m_shortcuts->size()), plan.size());
+    }
 
-    shortcutArgs.append(getWindowId());
-    shortcutArgs.append(bindOptions);
-    bindShortcuts.setArguments(shortcutArgs);
+    bindNext();
+}
 
-    QDBusMessage msg = QDBusConnection::sessionBus().call(bindShortcuts);
-    if (msg.type() != QDBusMessage::ReplyMessage) {
-        auto errMsg = QMessageBox(m_parentWindow);
-        errMsg.critical(m_parentWindow, u"Failed to bind shortcuts"_s, msg.errorMessage());
-        blog(LOG_ERROR, "[ShortcutsPortal] Failed to bind shortcuts: %s", msg.errorMessage().toUtf8().constData());
+// Toggles, push-to-talk and scenes are what people reach for first
+static int bindPriority(const ShortcutRegistry& registry, qsizetype index)
+{
+    switch (registry.category(index)) {
+    case ShortcutCategory::Toggle:
+    case ShortcutCategory::Macro:
+    case ShortcutCategory::Gesture:
+        return 0;
+    case ShortcutCategory::Scene:
+        return 2;
+    case ShortcutCategory::Hotkey:
+        break;
+    }
+
+    return registry.isHoldHotkey(index) ? 1 : 3;
+}
+
+// Session group used by PluginSettings::sessionPerCategory, see sessionGroupKeys
+static size_t sessionGroup(const ShortcutRegistry& registry, qsizetype index)
+{
+    switch (registry.category(index)) {
+    // macros and gestures mostly drive the same outputs as the toggles
+    case ShortcutCategory::Toggle:
+    case ShortcutCategory::Macro:
+    case ShortcutCategory::Gesture:
+        return 0;
+    case ShortcutCategory::Scene:
+        return 1;
+    case ShortcutCategory::Hotkey:
+        break;
+    }
+
+    // outputs, encoders, services and the frontend's own hotkeys share the last one
+    return registry.target(index).startsWith(u"source|") ? 2 : 3;
+}
+
+std::vector<ShortcutsPortal::SessionPlan> ShortcutsPortal::planSessions() const
+{
+    static const QString sessionGroupKeys[] = {u"toggles"_s, u"scenes"_s, u"sources"_s, u"outputs"_s};
+
+    const qsizetype chunkSize = m_settings.bindChunkSize;
+    const bool perCategory = m_settings.sessionPerCategory;
+
+    if (!perCategory && (chunkSize <= 0 || m_shortcuts->size() <= chunkSize)) {
+        return {SessionPlan{u"all"_s, ShortcutBindList{m_shortcuts, nullptr}}};
+    }
+
+    std::vector<int32_t> order(m_shortcuts->size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](int32_t a, int32_t b) {
+        return bindPriority(*m_shortcuts, a) < bindPriority(*m_shortcuts, b);
+    });
+
+    std::vector<int32_t> groups[std::size(sessionGroupKeys)];
+    for (int32_t index : order) {
+        groups[perCategory ? sessionGroup(*m_shortcuts, index) : 0].push_back(index);
+    }
+
+    std::vector<SessionPlan> plan;
+    for (size_t group = 0; group < std::size(groups); group++) {
+        const std::vector<int32_t>& indices = groups[group];
+        const QString key = perCategory ? sessionGroupKeys[group] : u"all"_s;
+        const size_t partSize = chunkSize > 0 ? static_cast<size_t>(chunkSize) : indices.size();
+
+        for (size_t start = 0; start < indices.size(); start += partSize) {
+            const size_t end = std::min(indices.size(), start + partSize);
+            auto part = std::make_shared<const std::vector<int32_t>>(indices.begin() + start, indices.begin() + end);
+
+            // the first part of a group keeps the plain key, so turning chunking on or off keeps it too
+            const QString partKey = start == 0 ? key : key + u'_' + QString::number(start / partSize + 1);
+            plan.push_back(SessionPlan{partKey, ShortcutBindList{m_shortcuts, std::move(part)}});
+        }
+    }
+
+    // nothing to bind still needs an entry, the first session then ends up empty
+    if (plan.empty()) {
+        plan.push_back(SessionPlan{u"all"_s, ShortcutBindList{m_shortcuts, nullptr}});
+    }
+
+    return plan;
+}
+
+void ShortcutsPortal::bindNext()
+{
+    // One request at a time and in plan order, so the first sessions become usable first
+    // and the portal isn't flooded with dialogs
+    for (PortalSession* session : m_sessions) {
+        if (session->isBinding() || (session->needsBind() && session->isCreating())) {
+            return;
+        }
+
+        // a session whose creation failed is retried on its own, bind the next ones meanwhile
+        if (session->needsBind() && session->isCreated()) {
+            session->bind(getWindowId());
+            return;
+        }
+    }
+
+    const bool allBound = std::all_of(m_sessions.begin(), m_sessions.end(), [](const PortalSession* session) {
+        return session->isBound() && session->isCreated();
+    });
+
+    if (allBound && m_recoveryElapsed.isValid()) {
+        blog(LOG_INFO, "[ShortcutsPortal] Shortcuts working again %lld ms after losing the portal sessions", static_cast<long long>(m_recoveryElapsed.elapsed()));
+        m_recoveryElapsed.invalidate();
+    }
+
+    if (allBound && m_bindRegistry && m_cachedRegistry.lock() != m_bindRegistry) {
+        blog(LOG_INFO, "[ShortcutsPortal] All %lld shortcuts bound in %zu session(s) after %lld ms", static_cast<long long>(m_bindRegistry->size()), m_sessions.size(), static_cast<long long>(m_bindAllTimer.elapsed()));
+
+        WarmStartCache::save(m_bindCollection, *m_bindRegistry);
+        m_cachedRegistry = m_bindRegistry;
+
+        Q_EMIT shortcutsBound();
     }
 }
 
@@ -455,6 +1238,10 @@ QString ShortcutsPortal::getWindowId()
 
 void ShortcutsPortal::configureShortcuts()
 {
+    if (!hasSession()) {
+        return;
+    }
+
     QDBusMessage bindShortcuts = QDBusMessage::createMethodCall(
         freedesktopDest,
         freedesktopPath,
@@ -463,16 +1250,17 @@ void ShortcutsPortal::configureShortcuts()
     );
 
     QMap<QString, QVariant> bindOptions;
-    bindOptions.insert(u"handle_token"_s, m_handleToken);
+    bindOptions.insert(u"handle_token"_s, m_primarySession->token());
 
+    // the shortcuts of every session belong to the same application
     QList<QVariant> shortcutArgs;
-    shortcutArgs.append(m_sessionObjPath);
+    shortcutArgs.append(m_primarySession->handle());
 
     shortcutArgs.append(getWindowId());
     shortcutArgs.append(bindOptions);
     bindShortcuts.setArguments(shortcutArgs);
 
-    QDBusMessage msg = QDBusConnection::sessionBus().call(bindShortcuts);
+    QDBusMessage msg = m_bus.call(bindShortcuts);
     if (msg.type() != QDBusMessage::ReplyMessage) {
         auto errMsg = QMessageBox(m_parentWindow);
         errMsg.critical(m_parentWindow, u"Failed to configure shortcuts"_s, msg.errorMessage());
@@ -483,26 +1271,51 @@ ShortcutsPortal::~ShortcutsPortal()
 {
     obs_frontend_remove_event_callback(obsFrontendEvent, this);
 
-    QDBusConnection::sessionBus().disconnect(
+    signal_handler_t* signals = obs_get_signal_handler();
+    signal_handler_disconnect(signals, "source_rename", onSourceChanged, this);
+    signal_handler_disconnect(signals, "source_remove", onSourceChanged, this);
+    signal_handler_disconnect(signals, "source_rename", onSourceRenamed, this);
+    signal_handler_disconnect(signals, "hotkey_register", onHotkeyRegister, this);
+    signal_handler_disconnect(signals, "hotkey_unregister", onHotkeyUnregister, this);
+
+    // stops posting to the dispatcher before it is deleted
+    m_triggerSocket.reset();
+
+    // sessions close themselves, which has to happen before the private connection goes away
+    qDeleteAll(m_sessions);
+    m_sessions.clear();
+    m_primarySession = nullptr;
+
+    m_bus.disconnect(
         freedesktopDest,
         freedesktopPath,
         globalShortcutsInterface,
         u"Activated"_s,
-        this,
+        m_dispatcher,
         SLOT(onActivatedSignal(
             QDBusObjectPath, QString, qulonglong, QVariantMap
         ))
     );
-    QDBusConnection::sessionBus().disconnect(
+    m_bus.disconnect(
         freedesktopDest,
         freedesktopPath,
         globalShortcutsInterface,
         u"Deactivated"_s,
-        this,
+        m_dispatcher,
         SLOT(onDeactivatedSignal(
             QDBusObjectPath, QString, qulonglong, QVariantMap
         ))
     );
+
+    if (m_dispatchThread) {
+        m_dispatchThread->quit();
+        m_dispatchThread->wait();
+
+        delete m_dispatcher;
+        delete m_dispatchThread;
+
+        QDBusConnection::disconnectFromBus(privateBusName);
+    }
 }
 
 void ShortcutsPortal::obsFrontendEvent(enum obs_frontend_event event, void* private_data)
@@ -518,15 +1331,30 @@ void ShortcutsPortal::obsFrontendEvent(enum obs_frontend_event event, void* priv
         event == OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED ||
         event == OBS_FRONTEND_EVENT_PROFILE_CHANGED) {
         
-        if (portal->m_isLoaded && !portal->m_sessionObjPath.path().isEmpty()) {
+        if (portal->m_isLoaded && portal->hasSession()) {
             // Use invokeMethod to ensure we run on the main thread's event loop
             // and avoid potential race conditions during state changes.
             QMetaObject::invokeMethod(portal, [portal]() {
-                portal->createShortcuts();
-                portal->bindShortcuts();
+                portal->scheduleUpdate();
             }, Qt::QueuedConnection);
         }
     }
 }
 
+void ShortcutsPortal::onSourceChanged(void* data, calldata_t* params)
+{
+    auto* portal = static_cast<ShortcutsPortal*>(data);
+
+    // only scenes have shortcuts that depend on the source name
+    auto* source = static_cast<obs_source_t*>(calldata_ptr(params, "source"));
+    if (!source || obs_source_get_type(source) != OBS_SOURCE_TYPE_SCENE) {
+        return;
+    }
+
+    // libobs signals can come from any thread
+    QMetaObject::invokeMethod(portal, [portal]() {
+        portal->scheduleHotkeyUpdate();
+    }, Qt::QueuedConnection);
+}
+
 #include "moc_shortcutsPortal.cpp"
@@ -18,20 +18,27 @@
 
 #pragma once
 
+#include "identityRegistry.h"
+#include "latencyStats.h"
+#include "gestureFile.h"
+#include "macroFile.h"
+#include "pluginSettings.h"
+#include "portalSession.h"
+#include "shortcutDispatcher.h"
+#include "shortcutRegistry.h"
+#include "triggerSocket.h"
+
+#include <QElapsedTimer>
 #include <QMainWindow>
 #include <QSet>
+#include <QThread>
+#include <QTimer>
 #include <QtDBus/QtDBus>
 #include <functional>
+#include <memory>
+#include <vector>
 #include <obs-frontend-api.h>
 
-struct PortalShortcut
-{
-    QString name;
-    QString description;
-
-    std::function<void(bool pressed)> callbackFunc;
-};
-
 class ShortcutsPortal : public QObject
 {
     Q_OBJECT
@@ -39,9 +46,9 @@ public:
     explicit ShortcutsPortal(QObject* parent = nullptr);
     ~ShortcutsPortal();
 
+    // Both are asynchronous, shortcuts are bound once the first session has been created
     void createSession();
-
-    int getVersion();
+    void probeVersion();
 
     void bindShortcuts();
     void configureShortcuts();
@@ -49,48 +56,177 @@ public:
     void createShortcut(
         const QString& name,
         const QString& description,
-        const std::function<void(bool pressed)>& callbackFunc
+        ShortcutCategory category,
+        const QString& target,
+        ShortcutAction action
     );
 
     void createShortcuts();
 
+    // Resolves the steps of the macros in macros.json, part of createShortcuts()
+    void createMacros();
+
+    // Adds the gestures in gestures.json, their targets are resolved by the registry's finalize()
+    void createGestures();
+
+    // What the shortcut a gesture runs acts on, see ShortcutRegistry::target(), empty if not found
+    QString gestureTarget(const TargetDefinition& definition, ShortcutCategory& category) const;
+
+    // Warns about gesture targets that didn't match any shortcut, needs a finalized registry
+    void checkGestures() const;
+
+    // Rebuilds the shortcuts and only binds them if they differ from the bound set
+    void updateShortcuts();
+
+    // Coalesces bursts of calls into a single updateShortcuts()
+    void scheduleUpdate();
+
+    std::shared_ptr<LatencyStats> stats() const
+    {
+        return m_stats;
+    }
+
+    // the set built last, replaced on every rebuild
+    std::shared_ptr<const ShortcutRegistry> shortcuts() const
+    {
+        return m_shortcuts;
+    }
+
     void setWindow(QMainWindow* window)
     {
         m_parentWindow = window;
     }
 
     static void obsFrontendEvent(enum obs_frontend_event event, void* private_data);
+    static void onSourceChanged(void* data, calldata_t* params);
+    static void onSourceRenamed(void* data, calldata_t* params);
+    static void onHotkeyRegister(void* data, calldata_t* params);
+    static void onHotkeyUnregister(void* data, calldata_t* params);
 
-public Q_SLOTS:
-    void onCreateSessionResponse(uint response, const QVariantMap& results);
-
-    void onActivatedSignal(
-        const QDBusObjectPath& sessionHandle,
-        const QString& shortcutName,
-        qulonglong timestamp,
-        const QVariantMap& options
-    );
+Q_SIGNALS:
+    void versionReceived(uint version);
 
-    void onDeactivatedSignal(
-        const QDBusObjectPath& sessionHandle,
-        const QString& shortcutName,
-        qulonglong timestamp,
-        const QVariantMap& options
-    );
+    // every session accepted its part of a set that wasn't bound before
+    void shortcutsBound();
 
 private:
     QString getWindowId();
 
-    QMap<QString, PortalShortcut> m_shortcuts;
+    void flushUpdate();
+    void logStats();
+
+    struct HotkeyInfo
+    {
+        QString description;
+        QString registererName;
+
+        // type, registerer UUID (or name) and hotkey name, see IdentityRegistry
+        QString identity;
+
+        // weak reference libobs keeps for the registerer, only compared, never dereferenced
+        void* registerer = nullptr;
+    };
+
+    void seedHotkeys();
+    void scheduleHotkeyUpdate();
 
-    const QString m_handleToken = "obs_portal_shortcuts";
-    const QString m_sessionHandleToken = "obs_portal_shortcuts_session";
+    // Binds the set cached by the last successful bind, false if there is none for the current collection
+    bool bindFromCache();
+
+    static bool captureHotkey(obs_hotkey_t* hotkey, HotkeyInfo& info);
+
+    // Fills in the cached shortcut of a hotkey libobs registered, see m_lazyHotkeys
+    void resolveLazyHotkey(obs_hotkey_id id, const HotkeyInfo& info);
+
+    // Hotkey named by a macro step or a gesture, m_hotkeys.cend() if there is none
+    QMap<obs_hotkey_id, HotkeyInfo>::const_iterator findNamedHotkey(const TargetDefinition& target) const;
+
+    static QDBusConnection openBus(const PluginSettings& settings);
+
+    PortalSession* addSession();
+    void onSessionCreated(PortalSession* session);
+    void onSessionClosed();
+    // retries with backoff through m_recoveryTimer
+    void onSessionCreateFailed(PortalSession* session);
+    void updateSessionHandles();
+    bool hasSession() const;
+
+    // xdg-desktop-portal restarted or closed our sessions: create them again and send
+    // each one the set it had, without waiting for the next update
+    void onPortalOwnerChanged(const QString& service, const QString& oldOwner, const QString& newOwner);
+    void recoverSessions();
+
+    struct SessionPlan
+    {
+        // identifies the part across rebuilds, so it stays on the same session
+        QString key;
+        ShortcutBindList shortcuts;
+    };
+
+    // How the current shortcuts are split across sessions, in binding order.
+    // See PluginSettings::bindChunkSize and PluginSettings::sessionPerCategory.
+    std::vector<SessionPlan> planSessions() const;
+
+    // Sends the next session's pending set, one request at a time
+    void bindNext();
+
+    PluginSettings m_settings;
+
+    // either the shared session bus or a private connection used by the dispatch thread
+    QDBusConnection m_bus;
+
+    std::shared_ptr<LatencyStats> m_stats;
+    QTimer m_statsTimer;
+    uint64_t m_loggedSamples = 0;
+
+    ShortcutDispatcher* m_dispatcher = nullptr;
+    QThread* m_dispatchThread = nullptr;
+
+    // only when enabled in the settings, feeds the dispatcher from its own thread
+    std::unique_ptr<TriggerSocket> m_triggerSocket;
+
+    // libobs hotkeys we expose, seeded once and then maintained from the hotkey signals
+    QMap<obs_hotkey_id, HotkeyInfo> m_hotkeys;
+    bool m_hotkeysSeeded = false;
+
+    IdentityRegistry m_identities;
+    MacroFile m_macros;
+    GestureFile m_gestures;
+
+    // replaced on every rebuild, the dispatcher may still hold on to the previous one
+    std::shared_ptr<ShortcutRegistry> m_shortcuts;
+
+    // LazyHotkey shortcuts of a set loaded from the warm start cache by hotkey identity.
+    // Resolved in one pass when it is bound and then as libobs registers the hotkeys,
+    // emptied once the set is rebuilt from the live hotkeys.
+    QHash<QString, qsizetype> m_lazyHotkeys;
 
     QMainWindow* m_parentWindow = nullptr;
 
-    QDBusObjectPath m_responseHandle;
-    QDBusObjectPath m_sessionObjPath;
+    // in binding order, more sessions are added when the set is split up
+    std::vector<PortalSession*> m_sessions;
+    int m_sessionCount = 0;
+
+    // created up front and kept open, ConfigureShortcuts goes through it
+    PortalSession* m_primarySession = nullptr;
+
+    // the set last sent to the portal, null when the next update has to bind again
+    std::shared_ptr<const ShortcutRegistry> m_bindRegistry;
+    QString m_bindCollection;
+    QElapsedTimer m_bindAllTimer;
+
+    QDBusServiceWatcher m_portalWatcher;
+    // creates the sessions that are missing, after a restart, a close or a failed create
+    QTimer m_recoveryTimer;
+    // runs from losing the sessions until every set is bound again
+    QElapsedTimer m_recoveryElapsed;
+
+    // the set last written to the warm start cache
+    std::weak_ptr<const ShortcutRegistry> m_cachedRegistry;
+
+    QTimer m_updateTimer;
+    QElapsedTimer m_pendingUpdateTimer;
+    int m_pendingUpdates = 0;
 
     bool m_isLoaded = false;
-    void* m_currentValidSources = nullptr;
 };
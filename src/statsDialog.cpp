@@ -0,0 +1,68 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "statsDialog.h"
+
+#include <QDialogButtonBox>
+#include <QFontDatabase>
+#include <QLabel>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+using namespace Qt::Literals::StringLiterals;
+
+StatsDialog::StatsDialog(std::shared_ptr<LatencyStats> stats, QWidget* parent)
+    : QDialog(parent)
+    , m_stats(std::move(stats))
+{
+    setWindowTitle(u"Wayland Hotkeys statistics"_s);
+    resize(560, 320);
+
+    auto* layout = new QVBoxLayout(this);
+
+    auto* label = new QLabel(u"Delay from the compositor seeing the key press to OBS running the action, and how long the action took."_s, this);
+    label->setWordWrap(true);
+    layout->addWidget(label);
+
+    m_text = new QPlainTextEdit(this);
+    m_text->setReadOnly(true);
+    m_text->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    layout->addWidget(m_text);
+
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    QPushButton* resetButton = buttons->addButton(u"Reset"_s, QDialogButtonBox::ResetRole);
+    layout->addWidget(buttons);
+
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::close);
+    connect(resetButton, &QPushButton::clicked, this, [this]() {
+        m_stats->reset();
+        refresh();
+    });
+
+    connect(&m_refreshTimer, &QTimer::timeout, this, &StatsDialog::refresh);
+    m_refreshTimer.start(1000);
+
+    refresh();
+}
+
+void StatsDialog::refresh()
+{
+    m_text->setPlainText(m_stats->summary());
+}
+
+#include "moc_statsDialog.cpp"
@@ -0,0 +1,41 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include "latencyStats.h"
+
+#include <QDialog>
+#include <QPlainTextEdit>
+#include <QTimer>
+#include <memory>
+
+class StatsDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit StatsDialog(std::shared_ptr<LatencyStats> stats, QWidget* parent = nullptr);
+
+private:
+    void refresh();
+
+    std::shared_ptr<LatencyStats> m_stats;
+
+    QPlainTextEdit* m_text = nullptr;
+    QTimer m_refreshTimer;
+};
@@ -0,0 +1,444 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "triggerSocket.h"
+
+#include <obs-module.h>
+
+#include <QFile>
+
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+
+enum FrameType : uint8_t {
+    Press = 0x01,
+    Release = 0x02,
+    List = 0x03,
+
+    ShortcutEntry = 0x81,
+    ListEnd = 0x82,
+    UnknownShortcut = 0xe1,
+};
+
+constexpr size_t frameHeaderSize = 3;
+constexpr size_t maxPayloadSize = 0xffff;
+
+constexpr size_t maxClients = 16;
+// recv() calls per wakeup, so a client that keeps writing can't hold on to the thread
+constexpr int maxReadsPerWakeup = 16;
+// a client that doesn't read its replies is dropped rather than buffered forever
+constexpr size_t maxPendingOutput = 4 * 1024 * 1024;
+
+void appendHeader(std::vector<uint8_t>& output, uint8_t type, size_t length)
+{
+    output.push_back(type);
+    output.push_back(static_cast<uint8_t>(length & 0xff));
+    output.push_back(static_cast<uint8_t>(length >> 8));
+}
+
+void appendBytes(std::vector<uint8_t>& output, const char* data, size_t length)
+{
+    output.insert(output.end(), data, data + length);
+}
+
+}
+
+TriggerSocket::TriggerSocket(ShortcutDispatcher* dispatcher)
+    : m_dispatcher(dispatcher)
+{
+}
+
+TriggerSocket::~TriggerSocket()
+{
+    if (m_thread.joinable()) {
+        const uint64_t value = 1;
+        if (write(m_wakeFd, &value, sizeof(value)) < 0) {
+            blog(LOG_WARNING, "[ShortcutsPortal] Failed to stop the trigger socket thread: %s", strerror(errno));
+        }
+        m_thread.join();
+    }
+
+    closeAll();
+}
+
+QString TriggerSocket::defaultPath()
+{
+    const QString runtimeDir = qEnvironmentVariable("XDG_RUNTIME_DIR");
+    if (runtimeDir.isEmpty()) {
+        return {};
+    }
+
+    // inside the Flatpak sandbox only the app's own runtime directory is shared with the host
+    const QString flatpakId = qEnvironmentVariable("FLATPAK_ID");
+    if (!flatpakId.isEmpty()) {
+        return runtimeDir + u"/app/"_s + flatpakId + u"/obs-wayland-hotkeys.sock"_s;
+    }
+
+    return runtimeDir + u"/obs-wayland-hotkeys.sock"_s;
+}
+
+bool TriggerSocket::start(const QString& path)
+{
+    const QByteArray encodedPath = QFile::encodeName(path);
+
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (encodedPath.size() >= static_cast<qsizetype>(sizeof(address.sun_path))) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Trigger socket path is too long: %s", encodedPath.constData());
+        return false;
+    }
+    memcpy(address.sun_path, encodedPath.constData(), encodedPath.size());
+
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Failed to create the trigger socket: %s", strerror(errno));
+        return false;
+    }
+
+    // a socket left behind by a crash is replaced, one another OBS instance listens on is not
+    struct stat existing {};
+    if (lstat(encodedPath.constData(), &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+        const int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        const bool inUse = probe >= 0 && ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) {
+            close(probe);
+        }
+
+        if (inUse) {
+            blog(LOG_WARNING, "[ShortcutsPortal] Trigger socket %s is already in use", encodedPath.constData());
+            closeAll();
+            return false;
+        }
+        unlink(encodedPath.constData());
+    }
+
+    if (bind(m_listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Failed to bind the trigger socket %s: %s", encodedPath.constData(), strerror(errno));
+        closeAll();
+        return false;
+    }
+    m_path = encodedPath;
+
+    if (chmod(encodedPath.constData(), 0600) < 0 || listen(m_listenFd, SOMAXCONN) < 0) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Failed to set up the trigger socket %s: %s", encodedPath.constData(), strerror(errno));
+        closeAll();
+        return false;
+    }
+
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epollFd < 0 || m_wakeFd < 0) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Failed to set up the trigger socket thread: %s", strerror(errno));
+        closeAll();
+        return false;
+    }
+
+    // without the wake descriptor the thread couldn't be stopped again
+    for (int fd : {m_listenFd, m_wakeFd}) {
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            blog(LOG_WARNING, "[ShortcutsPortal] Failed to set up the trigger socket thread: %s", strerror(errno));
+            closeAll();
+            return false;
+        }
+    }
+
+    m_thread = std::thread(&TriggerSocket::run, this);
+
+    blog(LOG_INFO, "[ShortcutsPortal] Listening for triggers on %s", encodedPath.constData());
+    return true;
+}
+
+void TriggerSocket::closeAll()
+{
+    for (const auto& entry : m_clients) {
+        close(entry.first);
+    }
+    m_clients.clear();
+
+    for (int* fd : {&m_listenFd, &m_epollFd, &m_wakeFd}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+
+    if (!m_path.isEmpty()) {
+        unlink(m_path.constData());
+        m_path.clear();
+    }
+}
+
+void TriggerSocket::run()
+{
+    epoll_event events[32];
+
+    while (true) {
+        const int count = epoll_wait(m_epollFd, events, std::size(events), -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            blog(LOG_ERROR, "[ShortcutsPortal] Trigger socket stopped: %s", strerror(errno));
+            return;
+        }
+
+        // Accepted after the rest of the batch: a client closed in this batch frees its
+        // descriptor, and a new connection reusing it would get the old one's events
+        bool pendingConnections = false;
+
+        for (int i = 0; i < count; i++) {
+            const int fd = events[i].data.fd;
+
+            if (fd == m_wakeFd) {
+                return;
+            }
+
+            if (fd == m_listenFd) {
+                pendingConnections = true;
+                continue;
+            }
+
+            auto it = m_clients.find(fd);
+            if (it == m_clients.end()) {
+                continue;
+            }
+
+            bool keep = true;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                keep = readClient(fd, it->second);
+            }
+            if (keep && (events[i].events & EPOLLOUT)) {
+                keep = writeClient(fd, it->second);
+            }
+            if (!keep) {
+                closeClient(fd);
+            }
+        }
+
+        if (pendingConnections) {
+            acceptClients();
+        }
+    }
+}
+
+void TriggerSocket::acceptClients()
+{
+    while (true) {
+        const int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                blog(LOG_WARNING, "[ShortcutsPortal] Failed to accept a trigger connection: %s", strerror(errno));
+            }
+            return;
+        }
+
+        // the socket is only accessible to us, but a bind mount could still expose it
+        ucred credentials {};
+        socklen_t length = sizeof(credentials);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) < 0 || credentials.uid != getuid()) {
+            close(fd);
+            continue;
+        }
+
+        if (m_clients.size() >= maxClients) {
+            blog(LOG_WARNING, "[ShortcutsPortal] Refusing trigger connection, %zu clients are already connected", m_clients.size());
+            close(fd);
+            continue;
+        }
+
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+
+        m_clients.emplace(fd, Client());
+    }
+}
+
+void TriggerSocket::closeClient(int fd)
+{
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    m_clients.erase(fd);
+}
+
+bool TriggerSocket::readClient(int fd, Client& client)
+{
+    uint8_t buffer[4096];
+
+    // Frames are handled after every recv(), so the input never holds more than one
+    // partial frame. Whatever is left after the last read is picked up on the next wakeup.
+    for (int reads = 0; reads < maxReadsPerWakeup; reads++) {
+        const ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received == 0) {
+            return false;
+        }
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            break;
+        }
+
+        client.input.insert(client.input.end(), buffer, buffer + received);
+        if (!handleFrames(client) || client.output.size() > maxPendingOutput) {
+            return false;
+        }
+    }
+
+    return client.output.empty() || writeClient(fd, client);
+}
+
+bool TriggerSocket::handleFrames(Client& client)
+{
+    // every complete frame is handled, a partial one waits for the rest
+    size_t offset = 0;
+    while (client.input.size() - offset >= frameHeaderSize) {
+        const uint8_t* frame = client.input.data() + offset;
+        const uint16_t length = static_cast<uint16_t>(frame[1] | (frame[2] << 8));
+        if (client.input.size() - offset - frameHeaderSize < static_cast<size_t>(length)) {
+            break;
+        }
+
+        if (!handleFrame(client, frame[0], frame + frameHeaderSize, length)) {
+            return false;
+        }
+        offset += frameHeaderSize + length;
+    }
+    client.input.erase(client.input.begin(), client.input.begin() + offset);
+
+    return true;
+}
+
+bool TriggerSocket::writeClient(int fd, Client& client)
+{
+    size_t sent = 0;
+    while (sent < client.output.size()) {
+        const ssize_t written = send(fd, client.output.data() + sent, client.output.size() - sent, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            break;
+        }
+        sent += written;
+    }
+    client.output.erase(client.output.begin(), client.output.begin() + sent);
+
+    // only ask for EPOLLOUT while there is something left to write
+    const bool waitForWrite = !client.output.empty();
+    if (waitForWrite != client.waitingForWrite) {
+        epoll_event event {};
+        event.events = waitForWrite ? EPOLLIN | EPOLLOUT : EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &event);
+        client.waitingForWrite = waitForWrite;
+    }
+
+    return true;
+}
+
+bool TriggerSocket::handleFrame(Client& client, uint8_t type, const uint8_t* payload, uint16_t length)
+{
+    switch (type) {
+    case Press:
+    case Release: {
+        const QString name = QString::fromUtf8(reinterpret_cast<const char*>(payload), length);
+
+        // the registry is immutable, so unknown names are answered here instead of on the dispatcher's thread
+        const std::shared_ptr<const ShortcutRegistry> registry = m_dispatcher->registry();
+        if (!registry || registry->find(name) < 0) {
+            appendHeader(client.output, UnknownShortcut, length);
+            appendBytes(client.output, reinterpret_cast<const char*>(payload), length);
+            return true;
+        }
+
+        m_dispatcher->post(name, type == Press);
+        return true;
+    }
+    case List:
+        appendList(client);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void TriggerSocket::appendList(Client& client)
+{
+    const std::shared_ptr<const ShortcutRegistry> registry = m_dispatcher->registry();
+
+    uint32_t count = 0;
+    if (registry) {
+        for (qsizetype i = 0; i < registry->size(); i++) {
+            const QByteArray name = registry->name(i).toUtf8();
+            QByteArray description = registry->description(i).toUtf8();
+
+            const size_t fixedSize = 1 + 2 + name.size();
+            if (fixedSize > maxPayloadSize) {
+                continue;
+            }
+
+            // long descriptions are cut to fit the frame, without splitting a UTF-8 sequence
+            if (fixedSize + description.size() > maxPayloadSize) {
+                qsizetype end = maxPayloadSize - fixedSize;
+                while (end > 0 && (static_cast<uint8_t>(description[end]) & 0xc0) == 0x80) {
+                    end--;
+                }
+                description.truncate(end);
+            }
+
+            appendHeader(client.output, ShortcutEntry, fixedSize + description.size());
+            client.output.push_back(static_cast<uint8_t>(registry->category(i)));
+            client.output.push_back(static_cast<uint8_t>(name.size() & 0xff));
+            client.output.push_back(static_cast<uint8_t>(name.size() >> 8));
+            appendBytes(client.output, name.constData(), name.size());
+            appendBytes(client.output, description.constData(), description.size());
+            count++;
+        }
+    }
+
+    appendHeader(client.output, ListEnd, sizeof(count));
+    for (int shift = 0; shift < 32; shift += 8) {
+        client.output.push_back(static_cast<uint8_t>(count >> shift));
+    }
+}
@@ -0,0 +1,100 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include "shortcutDispatcher.h"
+
+#include <QByteArray>
+#include <QString>
+#include <cstdint>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Local trigger API: a UNIX socket that presses and releases shortcuts by name without
+// going through the portal. Connections are served by a single epoll thread and events
+// are handed to the dispatcher like the portal signals.
+//
+// Every message is a frame: a type byte, a little endian 16 bit payload length, the payload.
+// Several frames can be sent in one write, they are dispatched as one batch.
+//
+//   0x01 press      payload: shortcut name (UTF-8)
+//   0x02 release    payload: shortcut name (UTF-8)
+//   0x03 list       no payload
+//
+// Replies, nothing is sent back for a press or release that was accepted:
+//
+//   0x81 shortcut   u8 category, u16 name length, name, description (rest of the payload)
+//   0x82 list end   u32 number of shortcuts
+//   0xe1 unknown    payload: the shortcut name that isn't bound
+//
+// A frame of any other type closes the connection.
+class TriggerSocket
+{
+public:
+    explicit TriggerSocket(ShortcutDispatcher* dispatcher);
+    ~TriggerSocket();
+
+    TriggerSocket(const TriggerSocket&) = delete;
+    TriggerSocket& operator=(const TriggerSocket&) = delete;
+
+    // Binds the socket and starts the thread, false if that failed
+    bool start(const QString& path);
+
+    // $XDG_RUNTIME_DIR/obs-wayland-hotkeys.sock, empty if the runtime dir isn't set
+    static QString defaultPath();
+
+private:
+    struct Client
+    {
+        std::vector<uint8_t> input;
+        std::vector<uint8_t> output;
+        bool waitingForWrite = false;
+    };
+
+    // closes every descriptor and removes the socket file
+    void closeAll();
+
+    void run();
+
+    void acceptClients();
+    void closeClient(int fd);
+
+    // false if the connection has to be closed
+    bool readClient(int fd, Client& client);
+    bool writeClient(int fd, Client& client);
+    // handles the complete frames in the input and keeps the rest
+    bool handleFrames(Client& client);
+    bool handleFrame(Client& client, uint8_t type, const uint8_t* payload, uint16_t length);
+
+    void appendList(Client& client);
+
+    ShortcutDispatcher* m_dispatcher;
+
+    QByteArray m_path;
+    int m_listenFd = -1;
+    int m_epollFd = -1;
+    // written to stop the thread
+    int m_wakeFd = -1;
+
+    std::thread m_thread;
+
+    // only touched on the socket thread
+    std::unordered_map<int, Client> m_clients;
+};
@@ -0,0 +1,105 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "warmStartCache.h"
+
+#include <obs-module.h>
+#include <util/bmem.h>
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+static constexpr quint32 cacheMagic = 0x4f574843; // "OWHC"
+static constexpr quint16 cacheFormat = 1;
+
+QString WarmStartCache::path()
+{
+    char* path = obs_module_config_path("warm_start.bin");
+    QString result = QString::fromUtf8(path);
+    bfree(path);
+    return result;
+}
+
+QList<CachedShortcut> WarmStartCache::load(const QString& collection)
+{
+    QFile file(path());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint16 format = 0;
+    QString cachedCollection;
+    quint32 count = 0;
+    stream >> magic >> format >> cachedCollection >> count;
+
+    if (stream.status() != QDataStream::Ok || magic != cacheMagic || format != cacheFormat || cachedCollection != collection) {
+        return {};
+    }
+
+    QList<CachedShortcut> shortcuts;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        CachedShortcut shortcut;
+        quint8 category = 0;
+        stream >> shortcut.name >> shortcut.description >> category >> shortcut.target;
+
+        if (category > static_cast<quint8>(ShortcutCategory::Gesture)) {
+            break;
+        }
+        shortcut.category = static_cast<ShortcutCategory>(category);
+        shortcuts.append(shortcut);
+    }
+
+    // a truncated file is as good as none, a partial set would unbind the rest
+    if (stream.status() != QDataStream::Ok || shortcuts.size() != static_cast<qsizetype>(count)) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Ignoring corrupt warm start cache %s", file.fileName().toUtf8().constData());
+        return {};
+    }
+
+    return shortcuts;
+}
+
+void WarmStartCache::save(const QString& collection, const ShortcutRegistry& registry)
+{
+    const QString filePath = path();
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Failed to save warm start cache to %s", filePath.toUtf8().constData());
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << cacheMagic << cacheFormat << collection << static_cast<quint32>(registry.size());
+
+    for (qsizetype i = 0; i < registry.size(); i++) {
+        stream << registry.name(i).toString() << registry.description(i).toString() << static_cast<quint8>(registry.category(i)) << registry.target(i).toString();
+    }
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        blog(LOG_WARNING, "[ShortcutsPortal] Failed to save warm start cache to %s", filePath.toUtf8().constData());
+    }
+}
@@ -0,0 +1,48 @@
+/*
+    OBS Wayland Hotkeys
+    Copyright (C) 2025 Leia <leia@tutamail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include "shortcutRegistry.h"
+
+#include <QList>
+#include <QString>
+
+struct CachedShortcut
+{
+    QString name;
+    QString description;
+    ShortcutCategory category = ShortcutCategory::Hotkey;
+
+    // see ShortcutRegistry::target()
+    QString target;
+};
+
+// The last set the portal accepted, stored in a small binary file so the next start
+// can bind it right away instead of waiting for OBS to load the scene collection
+class WarmStartCache
+{
+public:
+    // Empty if there is no cache or it belongs to another scene collection
+    static QList<CachedShortcut> load(const QString& collection);
+
+    static void save(const QString& collection, const ShortcutRegistry& registry);
+
+private:
+    static QString path();
+};